@@ -0,0 +1,142 @@
+#include "Engine.h"
+
+// Keeps every asset's block in the staging buffer aligned for any texel or block size
+#define ASSET_STAGING_ALIGNMENT 16
+
+namespace BB3D
+{
+	Uint32 AssetBatch::AddMesh(const char* filepath)
+	{
+		MeshAsset new_mesh_asset = {};
+		new_mesh_asset.filepath = filepath;
+		meshes.push_back(new_mesh_asset);
+		return meshes.size() - 1;
+	}
+
+	Uint32 AssetBatch::AddTexture(const char* filepath)
+	{
+		TextureAsset new_texture_asset = {};
+		new_texture_asset.filepath = filepath;
+		textures.push_back(new_texture_asset);
+		return textures.size() - 1;
+	}
+
+	void AssetBatch::Load(SDL_GPUDevice* device, ThreadPool& thread_pool, GeometryPool& geometry_pool)
+	{
+		BB3D_PROFILE_FUNCTION();
+		Uint64 load_start = SDL_GetTicksNS();
+
+		// Map and validate every file in parallel
+		for (MeshAsset& mesh_asset : meshes)
+			thread_pool.Submit([&mesh_asset] { mesh_asset.Read(); });
+		for (TextureAsset& texture_asset : textures)
+			thread_pool.Submit([&texture_asset] { texture_asset.Read(); });
+		thread_pool.Wait();
+
+		// The pool is sized for exactly this batch, one 32 bit mesh switches the whole pool to 32 bit indices
+		if (!meshes.empty() && !geometry_pool.vbo)
+		{
+			Uint32 total_vertices = 0;
+			Uint32 total_indices = 0;
+			SDL_GPUIndexElementSize pool_index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+			for (MeshAsset& mesh_asset : meshes)
+			{
+				total_vertices += mesh_asset.header.vertex_count;
+				total_indices += mesh_asset.header.index_count;
+				if (mesh_asset.header.index_size == sizeof(Uint32))
+					pool_index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT;
+			}
+
+			geometry_pool.Init(device, total_vertices, total_indices, pool_index_size);
+		}
+
+		// GPU objects are created on this thread, every asset gets its own aligned block of the staging buffer
+		Uint32 staging_size = 0;
+		for (MeshAsset& mesh_asset : meshes)
+		{
+			mesh_asset.Allocate(geometry_pool);
+			mesh_asset.staging_offset = staging_size;
+			staging_size += (mesh_asset.GetStagingSize() + ASSET_STAGING_ALIGNMENT - 1) & ~(ASSET_STAGING_ALIGNMENT - 1);
+		}
+		for (TextureAsset& texture_asset : textures)
+		{
+			texture_asset.SelectUploadFormat(device);
+			texture_asset.CreateTexture(device);
+			texture_asset.staging_offset = staging_size;
+			staging_size += (texture_asset.GetStagingSize() + ASSET_STAGING_ALIGNMENT - 1) & ~(ASSET_STAGING_ALIGNMENT - 1);
+		}
+
+		// Nothing to upload, but the mappings from Read are still open
+		if (!staging_size)
+		{
+			for (MeshAsset& mesh_asset : meshes)
+				mesh_asset.file.Close();
+			for (TextureAsset& texture_asset : textures)
+			{
+				texture_asset.subresources = nullptr;
+				texture_asset.file.Close();
+			}
+			return;
+		}
+
+		SDL_GPUTransferBufferCreateInfo staging_create_info = {};
+		staging_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+		staging_create_info.size = staging_size;
+		SDL_GPUTransferBuffer* staging_buff = SDL_CreateGPUTransferBuffer(device, &staging_create_info);
+		if (!staging_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create %u byte staging buffer for assets: %s\n", staging_size, SDL_GetError());
+			std::abort();
+		}
+
+		Uint8* staging_ptr = static_cast<Uint8*>(SDL_MapGPUTransferBuffer(device, staging_buff, false));
+		if (!staging_ptr)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map staging buffer for assets: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		// Copies and CPU block decodes land in disjoint ranges, so the workers never share a byte
+		for (MeshAsset& mesh_asset : meshes)
+			thread_pool.Submit([&mesh_asset, staging_ptr] { mesh_asset.Stage(staging_ptr); });
+		for (TextureAsset& texture_asset : textures)
+			thread_pool.Submit([&texture_asset, staging_ptr] { texture_asset.Stage(staging_ptr); });
+		thread_pool.Wait();
+
+		SDL_UnmapGPUTransferBuffer(device, staging_buff);
+
+		SDL_GPUCommandBuffer* upload_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
+		if (!upload_cmd_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to acquire command buffer for asset upload: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		SDL_GPUCopyPass* upload_pass = SDL_BeginGPUCopyPass(upload_cmd_buff);
+		if (!upload_pass)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to begin copy pass for asset upload: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		for (MeshAsset& mesh_asset : meshes)
+			mesh_asset.Upload(upload_pass, staging_buff);
+		for (TextureAsset& texture_asset : textures)
+			texture_asset.Upload(upload_pass, staging_buff);
+		SDL_EndGPUCopyPass(upload_pass);
+
+		SDL_GPUFence* upload_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(upload_cmd_buff);
+		if (!upload_fence)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit asset upload and acquire fence: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		SDL_WaitForGPUFences(device, true, &upload_fence, 1);
+		SDL_ReleaseGPUFence(device, upload_fence);
+		SDL_ReleaseGPUTransferBuffer(device, staging_buff);
+
+		SDL_LogInfo(SDL_LOG_CATEGORY_APPLICATION, "Loaded %zu meshes and %zu textures, %u KiB staged in %.2f ms\n",
+			meshes.size(), textures.size(), staging_size / 1024, static_cast<float>(SDL_GetTicksNS() - load_start) / static_cast<float>(SDL_NS_PER_MS));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "Engine.h"
+#include "nlohmann/json.hpp"
+#include <fstream>
+#include <algorithm>
+
+namespace BB3D
+{
+	static const char* BENCH_STAGE_NAMES[BenchStage::BENCH_STAGE_MAX] = { "update", "prepare", "upload", "record", "submit", "gpu_wait" };
+
+	// Nearest rank, the same rule the frame stats use for their 99th percentile
+	static float Percentile(std::vector<float> values, Uint32 percent)
+	{
+		if (values.empty())
+			return 0.0f;
+
+		size_t rank_idx = (values.size() * percent + 99) / 100;
+		rank_idx = rank_idx ? rank_idx - 1 : 0;
+		std::nth_element(values.begin(), values.begin() + rank_idx, values.end());
+		return values[rank_idx];
+	}
+
+	static nlohmann::json SummarizeTimes(const std::vector<float>& times)
+	{
+		float total_ms = 0.0f;
+		float max_ms = 0.0f;
+		for (float time_ms : times)
+		{
+			total_ms += time_ms;
+			max_ms = std::max(max_ms, time_ms);
+		}
+
+		nlohmann::json summary;
+		summary["avg"] = times.empty() ? 0.0f : total_ms / times.size();
+		summary["p50"] = Percentile(times, 50);
+		summary["p95"] = Percentile(times, 95);
+		summary["p99"] = Percentile(times, 99);
+		summary["max"] = max_ms;
+		return summary;
+	}
+
+	void Benchmark::BeginFrame()
+	{
+		current_frame = {};
+		frame_start = SDL_GetTicksNS();
+		stage_start = frame_start;
+	}
+
+	void Benchmark::MarkStage(BenchStage stage)
+	{
+		if (!is_enabled)
+			return;
+
+		Uint64 now = SDL_GetTicksNS();
+		current_frame.stage_ms[stage] += static_cast<float>(now - stage_start) / static_cast<float>(SDL_NS_PER_MS);
+		stage_start = now;
+	}
+
+	void Benchmark::EndFrame(const RenderStats& render_stats)
+	{
+		current_frame.frame_ms = static_cast<float>(SDL_GetTicksNS() - frame_start) / static_cast<float>(SDL_NS_PER_MS);
+		current_frame.render_stats = render_stats;
+		frames.push_back(current_frame);
+	}
+
+	void Benchmark::WriteReport(const char* driver_name, Resolution native_res, Resolution render_res)
+	{
+		// Warmup frames carry pipeline creation and first uploads, they would only skew the tail
+		std::vector<BenchFrame> measured_frames(frames.begin() + std::min<size_t>(warmup_count, frames.size()), frames.end());
+
+		std::vector<float> frame_times;
+		std::vector<float> stage_times[BenchStage::BENCH_STAGE_MAX];
+		Uint64 draw_calls = 0;
+		Uint64 binds_issued = 0;
+		Uint64 binds_saved = 0;
+		Uint64 render_passes = 0;
+		Uint64 entities_visible = 0;
+		Uint64 entities_culled = 0;
+		Uint64 bytes_uploaded = 0;
+		for (BenchFrame& frame : measured_frames)
+		{
+			frame_times.push_back(frame.frame_ms);
+			for (Uint32 i = 0; i < BenchStage::BENCH_STAGE_MAX; i++)
+				stage_times[i].push_back(frame.stage_ms[i]);
+
+			draw_calls += frame.render_stats.draw_calls;
+			binds_issued += frame.render_stats.binds_issued;
+			binds_saved += frame.render_stats.binds_saved;
+			render_passes += frame.render_stats.render_passes;
+			entities_visible += frame.render_stats.entities_visible;
+			entities_culled += frame.render_stats.entities_culled;
+			bytes_uploaded += frame.render_stats.bytes_uploaded;
+		}
+
+		double frame_div = measured_frames.empty() ? 1.0 : static_cast<double>(measured_frames.size());
+
+		nlohmann::json report;
+		report["scene"] = scene_path;
+		report["frames"] = measured_frames.size();
+		report["warmup_frames"] = warmup_count;
+		report["entities"] = measured_frames.empty() ? 0 : measured_frames.back().render_stats.entities_visible + measured_frames.back().render_stats.entities_culled;
+		report["scene_load_ms"] = scene_load_ms;
+		report["driver"] = driver_name ? driver_name : "unknown";
+		report["resolution"] = { native_res.w, native_res.h };
+		report["render_resolution"] = { render_res.w, render_res.h };
+		report["frame_ms"] = SummarizeTimes(frame_times);
+		for (Uint32 i = 0; i < BenchStage::BENCH_STAGE_MAX; i++)
+			report["stage_ms"][BENCH_STAGE_NAMES[i]] = SummarizeTimes(stage_times[i]);
+
+		// Per frame averages, the counters barely move along the path but the upload size does
+		report["per_frame"]["draw_calls"] = draw_calls / frame_div;
+		report["per_frame"]["binds_issued"] = binds_issued / frame_div;
+		report["per_frame"]["binds_saved"] = binds_saved / frame_div;
+		report["per_frame"]["render_passes"] = render_passes / frame_div;
+		report["per_frame"]["entities_visible"] = entities_visible / frame_div;
+		report["per_frame"]["entities_culled"] = entities_culled / frame_div;
+		report["per_frame"]["bytes_uploaded"] = bytes_uploaded / frame_div;
+		report["bytes_uploaded_total"] = bytes_uploaded;
+
+		std::ofstream report_f(report_path);
+		if (!report_f)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to open benchmark report at: %s\n", report_path.c_str());
+			std::abort();
+		}
+		report_f << report.dump(2);
+
+		SDL_Log("OK: Benchmarked %zu frames, %.3fms avg, %.3fms p99, report written to %s\n",
+			measured_frames.size(), report["frame_ms"]["avg"].get<float>(), report["frame_ms"]["p99"].get<float>(), report_path.c_str());
+	}
+
+	void Benchmark::Release(SDL_GPUDevice* device)
+	{
+		if (target)
+			SDL_ReleaseGPUTexture(device, target);
+
+		target = nullptr;
+	}
+}
\ No newline at end of file
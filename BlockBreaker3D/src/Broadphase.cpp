@@ -0,0 +1,128 @@
+#include "Engine.h"
+#include <cmath>
+
+namespace BB3D
+{
+	void CollisionGrid::Build(const std::vector<Entity>& entities, MeshType mesh_type, glm::vec2 new_cell_size, glm::vec2 new_item_half_extent)
+	{
+		cell_size = new_cell_size;
+		item_half_extent = new_item_half_extent;
+		columns = 0;
+		rows = 0;
+		cell_start.clear();
+		cell_count.clear();
+		items.clear();
+
+		// The grid only covers what it holds, so its size follows the level and not the world
+		glm::vec2 bounds_min = glm::vec2(0.0f);
+		glm::vec2 bounds_max = glm::vec2(0.0f);
+		bool has_items = false;
+		for (const Entity& current_entity : entities)
+		{
+			if (current_entity.mesh_type != mesh_type || !current_entity.is_active)
+				continue;
+
+			glm::vec2 center = glm::vec2(current_entity.position.x, current_entity.position.z);
+			bounds_min = has_items ? glm::vec2(std::fmin(bounds_min.x, center.x), std::fmin(bounds_min.y, center.y)) : center;
+			bounds_max = has_items ? glm::vec2(std::fmax(bounds_max.x, center.x), std::fmax(bounds_max.y, center.y)) : center;
+			has_items = true;
+		}
+
+		if (!has_items)
+			return;
+
+		origin = bounds_min;
+		columns = static_cast<Sint32>(std::floor((bounds_max.x - bounds_min.x) / cell_size.x + 0.5f)) + 1;
+		rows = static_cast<Sint32>(std::floor((bounds_max.y - bounds_min.y) / cell_size.y + 0.5f)) + 1;
+
+		// Counting sort into cells, one pass to size them and one to fill them
+		std::vector<Uint32> cell_fill(static_cast<size_t>(columns) * rows, 0);
+		for (const Entity& current_entity : entities)
+		{
+			if (current_entity.mesh_type != mesh_type || !current_entity.is_active)
+				continue;
+
+			cell_fill[GetRow(current_entity.position.z) * columns + GetColumn(current_entity.position.x)]++;
+		}
+
+		cell_start.resize(cell_fill.size());
+		Uint32 item_total = 0;
+		for (size_t i = 0; i < cell_fill.size(); i++)
+		{
+			cell_start[i] = item_total;
+			item_total += cell_fill[i];
+		}
+
+		items.resize(item_total);
+		cell_count.assign(cell_fill.size(), 0);
+		for (Uint32 i = 0; i < entities.size(); i++)
+		{
+			const Entity& current_entity = entities[i];
+			if (current_entity.mesh_type != mesh_type || !current_entity.is_active)
+				continue;
+
+			Uint32 cell_idx = GetRow(current_entity.position.z) * columns + GetColumn(current_entity.position.x);
+			items[cell_start[cell_idx] + cell_count[cell_idx]++] = i;
+		}
+	}
+
+	// Position has to be the one the entity was built or last moved with, that is the cell it sits in
+	void CollisionGrid::Remove(Uint32 entity_idx, glm::vec3 position)
+	{
+		if (!columns || !rows)
+			return;
+
+		Uint32 cell_idx = GetRow(position.z) * columns + GetColumn(position.x);
+		Uint32* cell_items = items.data() + cell_start[cell_idx];
+		for (Uint32 i = 0; i < cell_count[cell_idx]; i++)
+		{
+			if (cell_items[i] != entity_idx)
+				continue;
+
+			// Order inside a cell does not matter, callers sort what a query returns
+			cell_items[i] = cell_items[--cell_count[cell_idx]];
+			return;
+		}
+	}
+
+	void CollisionGrid::Query(glm::vec2 bounds_min, glm::vec2 bounds_max, std::vector<Uint32>& out_entities)
+	{
+		if (!columns || !rows)
+			return;
+
+		bounds_min -= item_half_extent;
+		bounds_max += item_half_extent;
+
+		// Entirely off the grid, nothing to clamp to
+		if (bounds_max.x < origin.x - cell_size.x * 0.5f || bounds_max.y < origin.y - cell_size.y * 0.5f ||
+			bounds_min.x > origin.x + cell_size.x * (columns - 0.5f) || bounds_min.y > origin.y + cell_size.y * (rows - 0.5f))
+			return;
+
+		Sint32 first_column = GetColumn(bounds_min.x);
+		Sint32 last_column = GetColumn(bounds_max.x);
+		Sint32 first_row = GetRow(bounds_min.y);
+		Sint32 last_row = GetRow(bounds_max.y);
+		for (Sint32 row = first_row; row <= last_row; row++)
+		{
+			for (Sint32 column = first_column; column <= last_column; column++)
+			{
+				Uint32 cell_idx = row * columns + column;
+				const Uint32* cell_items = items.data() + cell_start[cell_idx];
+				out_entities.insert(out_entities.end(), cell_items, cell_items + cell_count[cell_idx]);
+			}
+		}
+	}
+
+	// Cells are centered on the first item, so a level laid out at the cell pitch puts one item in each cell
+	Sint32 CollisionGrid::GetColumn(float x)
+	{
+		Sint32 column = static_cast<Sint32>(std::floor((x - origin.x) / cell_size.x + 0.5f));
+		return SDL_clamp(column, 0, columns - 1);
+	}
+
+	Sint32 CollisionGrid::GetRow(float z)
+	{
+		Sint32 row = static_cast<Sint32>(std::floor((z - origin.y) / cell_size.y + 0.5f));
+		return SDL_clamp(row, 0, rows - 1);
+	}
+}
\ No newline at end of file
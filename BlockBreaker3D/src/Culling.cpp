@@ -0,0 +1,118 @@
+#include "Engine.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BB3D_CULL_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace BB3D
+{
+	// ________________________________ Frustum ________________________________
+	Frustum Frustum::FromViewProj(const glm::mat4& view_proj)
+	{
+		Frustum new_frustum = {};
+
+		// Gribb/Hartmann, glm is column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+		glm::vec4 row_x = glm::vec4(view_proj[0][0], view_proj[1][0], view_proj[2][0], view_proj[3][0]);
+		glm::vec4 row_y = glm::vec4(view_proj[0][1], view_proj[1][1], view_proj[2][1], view_proj[3][1]);
+		glm::vec4 row_z = glm::vec4(view_proj[0][2], view_proj[1][2], view_proj[2][2], view_proj[3][2]);
+		glm::vec4 row_w = glm::vec4(view_proj[0][3], view_proj[1][3], view_proj[2][3], view_proj[3][3]);
+
+		// Left | Right | Bottom | Top | Near | Far
+		new_frustum.planes[0] = row_w + row_x;
+		new_frustum.planes[1] = row_w - row_x;
+		new_frustum.planes[2] = row_w + row_y;
+		new_frustum.planes[3] = row_w - row_y;
+		new_frustum.planes[4] = row_w + row_z;
+		new_frustum.planes[5] = row_w - row_z;
+
+		// Normalized so the plane distance of a point is in world units and can be compared against a radius
+		for (glm::vec4& plane : new_frustum.planes)
+			plane /= glm::length(glm::vec3(plane));
+
+		return new_frustum;
+	}
+
+	// ________________________________ Culling ________________________________
+	void CullEntities(const Frustum& frustum, std::vector<Entity>& entities, std::vector<Mesh>& meshes, std::vector<Uint8>& visibility, std::vector<float>& sphere_soa, RenderStats& stats)
+	{
+		// Round up to a whole number of 4 wide batches, the padding spheres are never visible
+		size_t padded_count = (entities.size() + 3) & ~static_cast<size_t>(3);
+		visibility.assign(padded_count, 0);
+
+		// World space bounding spheres in SoA layout so each plane test covers 4 entities at once
+		sphere_soa.assign(padded_count * 4, 0.0f);
+		float* center_x = sphere_soa.data();
+		float* center_y = center_x + padded_count;
+		float* center_z = center_y + padded_count;
+		float* radius = center_z + padded_count;
+
+		for (size_t i = 0; i < padded_count; i++)
+			radius[i] = -1.0f;
+
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			Entity& current_entity = entities[i];
+			if (!current_entity.is_active)
+				continue;
+
+			Mesh& entity_mesh = meshes[current_entity.mesh_type];
+			glm::mat4 transform = current_entity.GetRenderTransform();
+			glm::vec3 world_center = glm::vec3(transform * glm::vec4(entity_mesh.sphere_center, 1.0f));
+
+			// Non uniform scale stretches the sphere by the largest axis
+			float max_scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+
+			center_x[i] = world_center.x;
+			center_y[i] = world_center.y;
+			center_z[i] = world_center.z;
+			radius[i] = entity_mesh.sphere_radius * max_scale;
+		}
+
+#ifdef BB3D_CULL_SSE
+		for (size_t i = 0; i < padded_count; i += 4)
+		{
+			__m128 cx = _mm_loadu_ps(center_x + i);
+			__m128 cy = _mm_loadu_ps(center_y + i);
+			__m128 cz = _mm_loadu_ps(center_z + i);
+			__m128 r = _mm_loadu_ps(radius + i);
+			__m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+
+			// Inactive and padding lanes carry a negative radius and fail here
+			__m128 inside = _mm_cmpge_ps(r, _mm_setzero_ps());
+			for (const glm::vec4& plane : frustum.planes)
+			{
+				__m128 dist = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(cx, _mm_set1_ps(plane.x)), _mm_mul_ps(cy, _mm_set1_ps(plane.y))),
+					_mm_add_ps(_mm_mul_ps(cz, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w))
+				);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, neg_r));
+			}
+
+			int lane_mask = _mm_movemask_ps(inside);
+			for (int lane = 0; lane < 4; lane++)
+				visibility[i + lane] = (lane_mask >> lane) & 0x1;
+		}
+#else
+		for (size_t i = 0; i < padded_count; i++)
+		{
+			bool inside = radius[i] >= 0.0f;
+			for (const glm::vec4& plane : frustum.planes)
+				inside = inside && (center_x[i] * plane.x + center_y[i] * plane.y + center_z[i] * plane.z + plane.w >= -radius[i]);
+
+			visibility[i] = inside;
+		}
+#endif
+
+		for (size_t i = 0; i < entities.size(); i++)
+		{
+			if (!entities[i].is_active)
+				continue;
+
+			if (visibility[i])
+				stats.entities_visible++;
+			else
+				stats.entities_culled++;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include "Engine.h"
+#include <cmath>
+
+// Below half resolution the upscale blurs more than it saves
+#define RENDER_SCALE_MIN 0.5f
+#define RENDER_SCALE_MAX 1.0f
+
+// Frames between adjustments, gives a new scale time to show up in the measurements
+#define RENDER_SCALE_COOLDOWN 30
+#define RENDER_SCALE_SMOOTHING 0.1f
+// Aims a little under the frame budget so a spike does not miss the deadline straight away
+#define RENDER_SCALE_HEADROOM 0.9f
+#define RENDER_SCALE_MAX_STEP 0.1f
+#define RENDER_SCALE_MIN_STEP 0.02f
+
+namespace BB3D
+{
+	// What the options resolution entry steps through before switching to dynamic
+	static const float RENDER_SCALE_PRESETS[] = { 1.0f, 0.85f, 0.7f, 0.5f };
+	static const Uint32 RENDER_SCALE_PRESET_COUNT = sizeof(RENDER_SCALE_PRESETS) / sizeof(RENDER_SCALE_PRESETS[0]);
+
+	void DynamicResolution::Init(float new_fixed_scale, bool is_dynamic, float new_target_ms)
+	{
+		fixed_scale = SDL_clamp(new_fixed_scale, RENDER_SCALE_MIN, RENDER_SCALE_MAX);
+		mode = is_dynamic ? RenderScaleMode::RENDER_SCALE_DYNAMIC : RenderScaleMode::RENDER_SCALE_FIXED;
+		target_ms = new_target_ms;
+		scale = fixed_scale;
+		smoothed_ms = 0.0f;
+		cooldown = RENDER_SCALE_COOLDOWN;
+	}
+
+	void DynamicResolution::Update(float frame_cost_ms)
+	{
+		if (mode != RenderScaleMode::RENDER_SCALE_DYNAMIC)
+			return;
+
+		smoothed_ms = smoothed_ms > 0.0f ? smoothed_ms + (frame_cost_ms - smoothed_ms) * RENDER_SCALE_SMOOTHING : frame_cost_ms;
+		if (cooldown)
+		{
+			cooldown--;
+			return;
+		}
+
+		if (smoothed_ms <= 0.0f)
+			return;
+
+		// Fragment cost follows the pixel count, so the scale moves with the square root of the time ratio
+		float wanted_scale = scale * std::sqrt(target_ms * RENDER_SCALE_HEADROOM / smoothed_ms);
+		wanted_scale = SDL_clamp(wanted_scale, scale - RENDER_SCALE_MAX_STEP, scale + RENDER_SCALE_MAX_STEP);
+		wanted_scale = SDL_clamp(wanted_scale, RENDER_SCALE_MIN, RENDER_SCALE_MAX);
+
+		// Small corrections are noise, leave the resolution alone
+		if (std::fabs(wanted_scale - scale) < RENDER_SCALE_MIN_STEP)
+			return;
+
+		scale = wanted_scale;
+		cooldown = RENDER_SCALE_COOLDOWN;
+	}
+
+	void DynamicResolution::CycleMode()
+	{
+		if (mode == RenderScaleMode::RENDER_SCALE_DYNAMIC)
+		{
+			mode = RenderScaleMode::RENDER_SCALE_FIXED;
+			fixed_scale = RENDER_SCALE_PRESETS[0];
+			scale = fixed_scale;
+			return;
+		}
+
+		// Next preset below the current scale, past the last one the controller takes over from there
+		for (Uint32 i = 0; i < RENDER_SCALE_PRESET_COUNT; i++)
+		{
+			if (RENDER_SCALE_PRESETS[i] < fixed_scale - 0.001f)
+			{
+				fixed_scale = RENDER_SCALE_PRESETS[i];
+				scale = fixed_scale;
+				return;
+			}
+		}
+
+		mode = RenderScaleMode::RENDER_SCALE_DYNAMIC;
+		smoothed_ms = 0.0f;
+		cooldown = RENDER_SCALE_COOLDOWN;
+	}
+
+	Resolution DynamicResolution::GetRenderResolution(Resolution native_res)
+	{
+		Resolution render_res = {};
+		render_res.w = SDL_max(static_cast<unsigned int>(std::lround(native_res.w * scale)), 1u);
+		render_res.h = SDL_max(static_cast<unsigned int>(std::lround(native_res.h * scale)), 1u);
+		return render_res;
+	}
+
+	std::string DynamicResolution::GetLabel()
+	{
+		if (mode == RenderScaleMode::RENDER_SCALE_DYNAMIC)
+			return "Resolution: Dynamic";
+
+		return "Resolution: " + std::to_string(std::lround(fixed_scale * 100.0f)) + "%";
+	}
+}
\ No newline at end of file
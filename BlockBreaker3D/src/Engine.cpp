@@ -1,6 +1,8 @@
 #include "Engine.h"
 #include <iostream>
+#include <fstream>
 #include <stb_image.h>
+#include "nlohmann/json.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -11,7 +13,6 @@ namespace BB3D
 	// ________________________________ Globals (TEST) ________________________________
 	glm::mat4 proj(1.0f);
 	glm::mat4 proj_ui(1.0f);
-	glm::mat4 mvp(1.0f);
 
 	glm::mat4 model2(1.0f);
 	glm::mat4 model3(1.0f);
@@ -25,32 +26,76 @@ namespace BB3D
 	bool Engine::s_IsRunning = true;
 	TextureType Engine::s_SelectedTex = TextureType::SPACE_SKYBOX;
 	Resolution Engine::s_Resolution = {1280, 720};
+	DynamicResolution Engine::s_DynamicRes;
 
 	// ________________________________ Engine Lifetime ________________________________
 
+	void Engine::ParseArgs(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			if ((arg == "--record" || arg == "--replay") && i + 1 < argc)
+			{
+				m_InputReplay.mode = arg == "--record" ? ReplayMode::REPLAY_RECORD : ReplayMode::REPLAY_PLAYBACK;
+				m_InputReplay.filepath = argv[++i];
+			}
+			else if (arg == "--bench" && i + 1 < argc)
+			{
+				m_Bench.is_enabled = true;
+				m_Bench.scene_path = argv[++i];
+			}
+			else if (arg == "--frames" && i + 1 < argc)
+			{
+				m_Bench.frame_count = static_cast<Uint32>(SDL_strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--report" && i + 1 < argc)
+			{
+				m_Bench.report_path = argv[++i];
+			}
+			else
+			{
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring unknown argument: %s\n", argv[i]);
+			}
+		}
+
+		if (m_Bench.is_enabled && !m_Bench.frame_count)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Benchmark needs at least one frame, using 600\n");
+			m_Bench.frame_count = 600;
+		}
+	}
+
 	void Engine::Init()
 	{
+		// Benchmarks never present, the offscreen video driver still lets Vulkan come up without a display
+		if (m_Bench.is_enabled)
+			SDL_SetHint(SDL_HINT_VIDEO_DRIVER, "offscreen");
+
 		if (!SDL_Init(SDL_INIT_VIDEO))
 		{
 			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to initialize SDL3 and subsystems: %s\n", SDL_GetError());
 			std::abort();
 		}
 
-		s_Window = SDL_CreateWindow(
-			"Block Breaker 3D",
-			s_Resolution.w,
-			s_Resolution.h,
-			SDL_WINDOW_VULKAN
-		);
-
-		if (!s_Window)
+		if (!m_Bench.is_enabled)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to initialize window: %s\n", SDL_GetError());
-			std::abort();
-		}
+			s_Window = SDL_CreateWindow(
+				"Block Breaker 3D",
+				s_Resolution.w,
+				s_Resolution.h,
+				SDL_WINDOW_VULKAN
+			);
+
+			if (!s_Window)
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to initialize window: %s\n", SDL_GetError());
+				std::abort();
+			}
 
-		SDL_SetWindowPosition(s_Window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
-		SDL_SetWindowResizable(s_Window, false);
+			SDL_SetWindowPosition(s_Window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
+			SDL_SetWindowResizable(s_Window, false);
+		}
 
 		s_Device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, nullptr);
 
@@ -62,38 +107,74 @@ namespace BB3D
 
 		SDL_Log("OK: Created GPU handle with driver: %s\n", SDL_GetGPUDeviceDriver(s_Device));
 
-		if (!SDL_ClaimWindowForGPUDevice(s_Device, s_Window))
+		if (s_Window && !SDL_ClaimWindowForGPUDevice(s_Device, s_Window))
 		{
 			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to claim window for device: %s\n", SDL_GetError());
 			std::abort();
 		}
 
+		// Without a window every pipeline targets the offscreen stand in for the swapchain
+		m_ColorFormat = s_Window ? SDL_GetGPUSwapchainTextureFormat(s_Device, s_Window) : SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+
 		InitFreeType();
 		ParseSettingsJSON();
 
-		m_Timer.current_frame = SDL_GetTicks();
-		m_Timer.last_frame = m_Timer.current_frame;
-		m_Timer.elapsed_time = 0.0f;
+		// Uncapped and at a fixed scale, so two runs only differ by what changed in the code
+		if (m_Bench.is_enabled)
+		{
+			m_Timer.SetTargetRate(0);
+			s_DynamicRes.Init(s_DynamicRes.fixed_scale, false, s_DynamicRes.target_ms);
+		}
+
+		// A replay brings its own seed and tick rate, everything else starts from a fresh seed
+		Uint64 seed = SDL_GetPerformanceCounter();
+		if (m_InputReplay.mode == ReplayMode::REPLAY_PLAYBACK)
+		{
+			m_InputReplay.BeginPlayback(m_InputReplay.filepath.c_str());
+			seed = m_InputReplay.seed;
+			m_Timer.SetTickRate(m_InputReplay.tick_rate, m_Timer.max_ticks_per_frame);
+		}
+		else if (m_InputReplay.mode == ReplayMode::REPLAY_RECORD)
+		{
+			m_InputReplay.BeginRecording(m_InputReplay.filepath.c_str(), seed, SDL_NS_PER_SECOND / m_Timer.tick_time);
+		}
+
+		Scene::SeedRandom(seed);
 	}
 
 	void Engine::Run()
 	{
 		Setup();
+
+		if (m_Bench.is_enabled)
+		{
+			RunBenchmark();
+			return;
+		}
+
+		// Started after loading so the first frame does not carry the whole setup time
+		m_Timer.Start();
 		while (s_IsRunning)
 		{
 			if (!m_IsIdle)
 			{
+				BB3D_PROFILE_ZONE("Frame");
 				Input();
 				Update();
 				Render();
 				UpdateDeltaTime();
-				CopyPrevInput();
 			}
 		}
 	}
 
 	void Engine::Destroy()
 	{
+		m_InputReplay.EndRecording();
+
+		// Dump once the workers are joined so no ring is still being written
+		m_ThreadPool.Shutdown();
+		BB3D_PROFILE_DUMP("bb3d_trace.json");
+
 		// Freetype and Fonts
 		DestroyFreeType();
 
@@ -102,24 +183,29 @@ namespace BB3D
 		SDL_ReleaseGPUGraphicsPipeline(s_Device, m_PipelineModelsPhong);
 		SDL_ReleaseGPUGraphicsPipeline(s_Device, m_PipelineSkybox);
 		SDL_ReleaseGPUGraphicsPipeline(s_Device, m_PipelineUI);
+		SDL_ReleaseGPUComputePipeline(s_Device, m_PipelineLightCull);
 
-		for (Mesh& disposed_mesh : m_Meshes)
-		{
-			SDL_ReleaseGPUBuffer(s_Device, disposed_mesh.vbo);
-			SDL_ReleaseGPUBuffer(s_Device, disposed_mesh.ibo);
-		}
-
+		m_GeometryPool.Release(s_Device);
 		SDL_ReleaseGPUBuffer(s_Device, m_UIBuff);
+		m_InstanceBuff.Release(s_Device);
+		m_LightBuff.Release(s_Device);
+		ui_layer.Release(s_Device);
 
 		for (SDL_GPUTexture* disposed_texture : m_Textures)
 		{
 			SDL_ReleaseGPUTexture(s_Device, disposed_texture);
 		}
+		m_Skyboxes.Release(s_Device);
 		SDL_ReleaseGPUTexture(s_Device, test_font.atlas_texture);
-		SDL_ReleaseGPUSampler(s_Device, m_Sampler);
+		m_Samplers.Release(s_Device);
+
+		m_Bench.Release(s_Device);
 
-		SDL_ReleaseWindowFromGPUDevice(s_Device, s_Window);
-		SDL_DestroyWindow(s_Window);
+		if (s_Window)
+		{
+			SDL_ReleaseWindowFromGPUDevice(s_Device, s_Window);
+			SDL_DestroyWindow(s_Window);
+		}
 		SDL_DestroyGPUDevice(s_Device);
 		SDL_Quit();
 	}
@@ -135,124 +221,92 @@ namespace BB3D
 		std::memset(m_InputState.prev_mousebtn, 0, sizeof(m_InputState.prev_mousebtn));
 		m_InputState.relx = 0;
 		m_InputState.rely = 0;
+		m_InputState.current_mouse_x = 0;
+		m_InputState.current_mouse_y = 0;
+		m_InputState.prev_mouse_x = 0;
+		m_InputState.prev_mouse_y = 0;
+
+		// One worker per core left over after the main thread
+		m_ThreadPool.Init(SDL_max(SDL_GetNumLogicalCPUCores() - 1, 1));
 
 		// Allocate storage
 		m_Meshes.reserve(16);
 		m_Textures.reserve(16);
 
 		// Load Textures
-		// DEPTH TEXTURE IS ALWAYS IDX 0, SKYBOX TEXTURE IS ALWAYS IDX 1
+		// DEPTH TEXTURE IS ALWAYS IDX 0, MATERIAL ARRAY IS ALWAYS IDX 1, SCENE COLOR IS ALWAYS IDX 2, SKYBOXES LIVE IN m_Skyboxes
+		// Material layers are in TextureType order starting from GEM10
 		m_Textures.push_back(CreateDepthTestTexture(s_Device, s_Resolution.w, s_Resolution.h));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/gem_10.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/gem_03.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/metal_07.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/paddle.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/gem_13.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/metal_21.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/block_1.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/block_2.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/block_3.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/block_4.png"));
-		m_Textures.push_back(CreateAndLoadTextureToGPU(s_Device, "assets/textures/block_5.png"));
-		m_Textures.push_back(CreateAndLoadCubeMapToGPU(
-			s_Device,
-			{
-				"assets/skyboxes/space/space_right.png",
-				"assets/skyboxes/space/space_left.png",
-				"assets/skyboxes/space/space_up.png",
-				"assets/skyboxes/space/space_down.png",
-				"assets/skyboxes/space/space_front.png",
-				"assets/skyboxes/space/space_back.png"
-			}
-		));
-		m_Textures.push_back(CreateAndLoadCubeMapToGPU(
-			s_Device,
-			{
-				"assets/skyboxes/techno/techno_right.png",
-				"assets/skyboxes/techno/techno_left.png",
-				"assets/skyboxes/techno/techno_up.png",
-				"assets/skyboxes/techno/techno_down.png",
-				"assets/skyboxes/techno/techno_front.png",
-				"assets/skyboxes/techno/techno_back.png"
-			}
-		));
-		m_Textures.push_back(CreateAndLoadCubeMapToGPU(
-			s_Device,
-			{
-				"assets/skyboxes/sinister/sinister_right.png",
-				"assets/skyboxes/sinister/sinister_left.png",
-				"assets/skyboxes/sinister/sinister_up.png",
-				"assets/skyboxes/sinister/sinister_down.png",
-				"assets/skyboxes/sinister/sinister_front.png",
-				"assets/skyboxes/sinister/sinister_back.png"
-			}
-		));
-		m_Textures.push_back(CreateAndLoadCubeMapToGPU(
-			s_Device,
-			{
-				"assets/skyboxes/nether/nether_right.png",
-				"assets/skyboxes/nether/nether_left.png",
-				"assets/skyboxes/nether/nether_up.png",
-				"assets/skyboxes/nether/nether_down.png",
-				"assets/skyboxes/nether/nether_front.png",
-				"assets/skyboxes/nether/nether_back.png"
-			}
-		));
-		m_Textures.push_back(CreateAndLoadCubeMapToGPU(
-			s_Device,
+
+		// Skyboxes follow TextureType order starting from SPACE_SKYBOX, only the shown one is loaded up front
+		m_Skyboxes.Init(
 			{
-				"assets/skyboxes/classic/classic_right.png",
-				"assets/skyboxes/classic/classic_left.png",
-				"assets/skyboxes/classic/classic_up.png",
-				"assets/skyboxes/classic/classic_down.png",
-				"assets/skyboxes/classic/classic_front.png",
-				"assets/skyboxes/classic/classic_back.png"
-			}
-		));
+				"assets/skyboxes/space.bb3dtex",
+				"assets/skyboxes/techno.bb3dtex",
+				"assets/skyboxes/sinister.bb3dtex",
+				"assets/skyboxes/nether.bb3dtex",
+				"assets/skyboxes/classic.bb3dtex"
+			},
+			m_SkyboxBudget
+		);
+		Uint32 startup_skybox_idx = s_SelectedTex - TextureType::SPACE_SKYBOX;
+
+		// Baked from assets at build time by MeshBaker and TextureBaker, uploaded together in one batch
+		AssetBatch startup_assets = {};
+		Uint32 material_asset_idx = startup_assets.AddTexture("assets/textures/materials.bb3dtex");
+		Uint32 skybox_asset_idx = startup_assets.AddTexture(m_Skyboxes.slots[startup_skybox_idx].filepath.c_str());
+		// Mesh order follows MeshType
+		startup_assets.AddMesh("assets/meshes/ico.bb3dmesh");
+		startup_assets.AddMesh("assets/meshes/quad.bb3dmesh");
+		startup_assets.AddMesh("assets/meshes/sphere.bb3dmesh");
+		startup_assets.AddMesh("assets/meshes/paddle.bb3dmesh");
+		startup_assets.AddMesh("assets/meshes/block.bb3dmesh");
+		startup_assets.Load(s_Device, m_ThreadPool, m_GeometryPool);
+
+		m_Textures.push_back(startup_assets.textures[material_asset_idx].texture);
+		// Window sized so any render scale fits, a lower scale only draws into its top left corner
+		m_Textures.push_back(CreateColorTargetTexture(s_Device, m_ColorFormat, s_Resolution.w, s_Resolution.h));
+		m_Skyboxes.AdoptTexture(startup_skybox_idx, startup_assets.textures[skybox_asset_idx]);
+
+		for (MeshAsset& mesh_asset : startup_assets.meshes)
+			m_Meshes.push_back(mesh_asset.mesh);
 
 		test_font = CreateFontAtlasFromFile(s_Device, "assets/fonts/DejaVuSansMono.ttf");
 
-		// Load Meshes
-		m_Meshes.push_back(LoadMeshFromFile(s_Device, "assets/meshes/ico.obj"));
-		m_Meshes.push_back(LoadMeshFromFile(s_Device, "assets/meshes/quad.obj"));
-		m_Meshes.push_back(LoadMeshFromFile(s_Device, "assets/meshes/sphere.obj"));
-		m_Meshes.push_back(LoadMeshFromFile(s_Device, "assets/meshes/paddle.obj"));
-		m_Meshes.push_back(LoadMeshFromFile(s_Device, "assets/meshes/block.obj"));
-
 		// Load Shaders and Setup Pipelines
-		SDL_GPUShader* phong_vert_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-phong.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-		SDL_GPUShader* phong_frag_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-phong.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 1, 0, 0);
-		SDL_GPUShader* no_phong_vert_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-no-phong.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-		SDL_GPUShader* no_phong_frag_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-no-phong.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
+		SDL_GPUShader* phong_vert_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-phong-instanced.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 1, 0);
+		SDL_GPUShader* phong_frag_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-phong-instanced.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 1, 3, 0);
+		SDL_GPUShader* no_phong_vert_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-no-phong-instanced.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 1, 0);
+		SDL_GPUShader* no_phong_frag_shader_model = CreateShaderFromFile(s_Device, "Shaders/model-no-phong-instanced.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
 		SDL_GPUShader* skybox_vert_shader = CreateShaderFromFile(s_Device, "Shaders/skybox.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
-		SDL_GPUShader* skybox_frag_shader = CreateShaderFromFile(s_Device, "Shaders/skybox.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
+		SDL_GPUShader* skybox_frag_shader = CreateShaderFromFile(s_Device, "Shaders/skybox.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 1, 0, 0);
 		SDL_GPUShader* ui_vert_shader = CreateShaderFromFile(s_Device, "Shaders/ui.vert.spv", SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 0, 0);
 		SDL_GPUShader* ui_frag_shader = CreateShaderFromFile(s_Device, "Shaders/ui.frag.spv", SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, 0);
 
 		m_PipelineModelsPhong = CreateGraphicsPipelineForModels(
 			s_Device, 
-			SDL_GetGPUSwapchainTextureFormat(s_Device, s_Window),
+			m_ColorFormat,
 			phong_vert_shader_model,
 			phong_frag_shader_model
 		);
 
 		m_PipelineModelsNoPhong = CreateGraphicsPipelineForModels(
 			s_Device,
-			SDL_GetGPUSwapchainTextureFormat(s_Device, s_Window),
+			m_ColorFormat,
 			no_phong_vert_shader_model,
 			no_phong_frag_shader_model
 		);
 
 		m_PipelineSkybox = CreateGraphicsPipelineForSkybox(
 			s_Device,
-			SDL_GetGPUSwapchainTextureFormat(s_Device, s_Window),
+			m_ColorFormat,
 			skybox_vert_shader,
 			skybox_frag_shader
 		);
 
 		m_PipelineUI = CreateGraphicsPipelineForUI(
 			s_Device,
-			SDL_GetGPUSwapchainTextureFormat(s_Device, s_Window),
+			m_ColorFormat,
 			ui_vert_shader,
 			ui_frag_shader
 		);
@@ -266,13 +320,49 @@ namespace BB3D
 		SDL_ReleaseGPUShader(s_Device, ui_vert_shader);
 		SDL_ReleaseGPUShader(s_Device, ui_frag_shader);
 
-		m_Sampler = CreateSampler(s_Device, SDL_GPU_FILTER_NEAREST);
+		// 64 threads matches local_size_x in light-cull.comp
+		m_PipelineLightCull = CreateComputePipelineFromFile(s_Device, "Shaders/light-cull.comp.spv", 1, 2, 1, 64);
+		m_LightBuff.Init(s_Device);
+
+		// Materials are minified heavily on distant blocks and the stretched floor, so they get trilinear plus anisotropy
+		SamplerDesc material_sampler_desc = {};
+		material_sampler_desc.filter = SDL_GPU_FILTER_LINEAR;
+		material_sampler_desc.mip_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
+		material_sampler_desc.address_mode = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+		material_sampler_desc.max_anisotropy = m_Anisotropy;
+		m_MaterialSampler = m_Samplers.Get(s_Device, material_sampler_desc);
+
+		// Clamped so the cube seams do not pick up the opposite edge
+		SamplerDesc skybox_sampler_desc = {};
+		skybox_sampler_desc.filter = SDL_GPU_FILTER_LINEAR;
+		skybox_sampler_desc.mip_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
+		skybox_sampler_desc.address_mode = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+		m_SkyboxSampler = m_Samplers.Get(s_Device, skybox_sampler_desc);
+
+		// Glyphs are drawn at their native size
+		SamplerDesc ui_sampler_desc = {};
+		ui_sampler_desc.address_mode = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
+		m_UISampler = m_Samplers.Get(s_Device, ui_sampler_desc);
 
 		m_UIBuff = CreateUILayerBuffer(s_Device);
+		ui_layer.Init(s_Device);
 
 		// Scene Initialization
 		// TODO harcode gamescene as idx 0
-		s_SceneStack.push(std::make_unique<MenuScene>("assets/scenes/mainmenu.json", SceneTransToCallback));
+		if (m_Bench.is_enabled)
+		{
+			// The camera path spans the warmup as well, so the measured frames start a little way into the lap
+			m_Bench.warmup_count = SDL_min(m_Bench.frame_count / 10, 60u);
+			m_Bench.target = CreateColorTargetTexture(s_Device, m_ColorFormat, s_Resolution.w, s_Resolution.h);
+
+			Uint64 load_start = SDL_GetTicksNS();
+			s_SceneStack.push(std::make_unique<BenchScene>(m_Bench.scene_path.c_str(), SceneTransToCallback, m_Bench.warmup_count + m_Bench.frame_count));
+			m_Bench.scene_load_ms = static_cast<float>(SDL_GetTicksNS() - load_start) / static_cast<float>(SDL_NS_PER_MS);
+		}
+		else
+		{
+			s_SceneStack.push(std::make_unique<MenuScene>("assets/scenes/mainmenu.bb3dscene", SceneTransToCallback));
+		}
 		
 		// Uniform data
 		float f_w = static_cast<float>(s_Resolution.w);
@@ -283,153 +373,270 @@ namespace BB3D
 
 	void Engine::Update()
 	{
-		s_SceneStack.top()->Update(m_InputState, m_Timer.elapsed_time);
+		BB3D_PROFILE_FUNCTION();
+		// Fixed steps so the simulation cost and its results do not depend on the render rate
+		const float tick_delta = m_Timer.GetTickDelta();
+		while (s_IsRunning && m_Timer.ConsumeTick())
+		{
+			BB3D_PROFILE_ZONE("SimulationTick");
+
+			// Playback overwrites the live input, the session ends with the recording
+			Scene* current_scene = s_SceneStack.top().get();
+			if (m_InputReplay.mode == ReplayMode::REPLAY_PLAYBACK && !m_InputReplay.PlaybackTick(m_InputState, current_scene->GetStateHash()))
+			{
+				if (m_InputReplay.is_desynced)
+					SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Replay finished after %u ticks but did not reproduce the recorded state\n", m_InputReplay.tick_count);
+				else
+					SDL_Log("OK: Replay finished after %u ticks\n", m_InputReplay.tick_count);
+				s_IsRunning = false;
+				break;
+			}
+			if (m_InputReplay.mode == ReplayMode::REPLAY_RECORD)
+				m_InputReplay.RecordTick(m_InputState, current_scene->GetStateHash());
+
+			for (Entity& current_entity : current_scene->GetSceneEntities())
+				current_entity.StorePrevState();
+
+			current_scene->Update(m_InputState, tick_delta);
+
+			// Input edges are consumed per tick, so a press is seen exactly once however many ticks run
+			CopyPrevInput();
+		}
+
+		// Toggling only requests the skybox, the old one is shown until the new one finishes loading
+		m_Skyboxes.Request(s_SelectedTex - TextureType::SPACE_SKYBOX);
+		m_Skyboxes.Update(s_Device, m_ThreadPool);
 	}
 
 	// ________________________________ Runtime ________________________________
 	void Engine::Render()
 	{
+		BB3D_PROFILE_FUNCTION();
 		SDL_GPUCommandBuffer* cmd_buff = SDL_AcquireGPUCommandBuffer(s_Device);
 
-		SDL_GPUTexture* swapchain_tex;
-		if (!SDL_WaitAndAcquireGPUSwapchainTexture(
-			cmd_buff, 
-			s_Window, 
-			&swapchain_tex, 
-			nullptr, 
-			nullptr
-		))
+		SDL_GPUTexture* swapchain_tex = m_Bench.target;
+		m_Timer.present_wait_time = 0;
+		if (!m_Bench.is_enabled)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to acquire swapchain texture: %s\n", SDL_GetError());
-			std::abort();
-		}
+			BB3D_PROFILE_ZONE("AcquireSwapchain");
+			Uint64 acquire_start = SDL_GetTicksNS();
+			if (!SDL_WaitAndAcquireGPUSwapchainTexture(
+				cmd_buff, 
+				s_Window, 
+				&swapchain_tex, 
+				nullptr, 
+				nullptr
+			))
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to acquire swapchain texture: %s\n", SDL_GetError());
+				std::abort();
+			}
 
-		SDL_GPUColorTargetInfo color_target_info = {};
-		color_target_info.texture = swapchain_tex;
-		color_target_info.load_op = SDL_GPU_LOADOP_LOAD;
-		color_target_info.clear_color = {1.0, 0.0, 1.0, 1.0};
-		color_target_info.store_op = SDL_GPU_STOREOP_STORE;
-
-		SDL_GPUDepthStencilTargetInfo depth_stencil_target_info = {};
-		depth_stencil_target_info.texture = m_Textures[DEPTH_TEXTURE_IDX];
-		depth_stencil_target_info.load_op = SDL_GPU_LOADOP_CLEAR;
-		depth_stencil_target_info.clear_depth = 1;
-		depth_stencil_target_info.store_op = SDL_GPU_STOREOP_DONT_CARE;
-
-		SDL_GPURenderPass* render_pass_skybox = SDL_BeginGPURenderPass(
-			cmd_buff,
-			&color_target_info,
-			1,
-			nullptr
-		);
+			// With vsync this blocks until the next present slot, idle time the frame cost must not count
+			m_Timer.present_wait_time = SDL_GetTicksNS() - acquire_start;
+		}
 
-		// Stage 1: Skybox
-		SDL_BindGPUGraphicsPipeline(render_pass_skybox, m_PipelineSkybox);
-		SDL_GPUTextureSamplerBinding skybox_bind = { m_Textures[s_SelectedTex], m_Sampler};
-		SDL_BindGPUFragmentSamplers(render_pass_skybox, 0, &skybox_bind, 1);
-		glm::mat4 vp_sky(1.0f);
-		glm::mat4 view_no_transform = glm::mat4(glm::mat3(s_SceneStack.top()->GetSceneCamera().GetViewMatrix()));
-		vp_sky = proj * view_no_transform;
-		SDL_PushGPUVertexUniformData(cmd_buff, 0, glm::value_ptr(vp_sky), sizeof(vp_sky));
-		SDL_DrawGPUPrimitives(render_pass_skybox, 36, 1, 0, 0);
-		SDL_EndGPURenderPass(render_pass_skybox);
-
-		SDL_GPURenderPass* render_pass_models = SDL_BeginGPURenderPass(
-			cmd_buff,
-			&color_target_info,
-			1,
-			&depth_stencil_target_info
-		);
-		SDL_GPUBufferBinding binding = { m_Meshes[2].vbo, 0};
-		SDL_BindGPUVertexBuffers(render_pass_models, 0, &binding, 1);
-		SDL_GPUBufferBinding ind_bind = { m_Meshes[2].ibo, 0 };
-		SDL_BindGPUIndexBuffer(render_pass_models, &ind_bind, SDL_GPU_INDEXELEMENTSIZE_16BIT);
-		SDL_GPUTextureSamplerBinding tex_bind = {m_Textures[3], m_Sampler};
-		SDL_BindGPUFragmentSamplers(render_pass_models, 0, &tex_bind, 1);
-
-		// Stage 2: 3D Models
-
-		// Light Sources
-		glm::vec4 light_positions[32] = { glm::vec4(0.0f) };
-		glm::vec4 origin = { 0.0f, 0.0f, 0.0f, 1.0f };
-		int light_count = 0;
-		SDL_BindGPUGraphicsPipeline(render_pass_models, m_PipelineModelsNoPhong);
+		// Blend every entity between its last two simulation ticks, benchmarks step exactly one tick per frame
+		const float tick_alpha = m_Bench.is_enabled ? 1.0f : m_Timer.GetTickAlpha();
 		for (Entity& current_entity : s_SceneStack.top()->GetSceneEntities())
-		{
-			if (current_entity.is_shaded)
-				continue;
-			if (!current_entity.is_active)
-				continue;
+			current_entity.Interpolate(tick_alpha);
+
+		// The 3D scene may render below window resolution, the UI always draws at full resolution
+		Resolution render_res = s_DynamicRes.GetRenderResolution(s_Resolution);
+		bool is_scaled = render_res.w != s_Resolution.w || render_res.h != s_Resolution.h;
+
+		// Stage 0: Cull and sort submissions, stream UI vertices and upload everything in one copy pass
+		m_RenderStats = {};
+		Camera scene_cam = s_SceneStack.top()->GetSceneCamera();
+		glm::mat4 scene_view = scene_cam.GetViewMatrix();
+		CullEntities(Frustum::FromViewProj(proj * scene_view), s_SceneStack.top()->GetSceneEntities(), m_Meshes, m_Visibility, m_CullSpheres, m_RenderStats);
+		// Pixels covered by one world unit at distance 1, LODs are picked by how large their error projects on screen
+		float pixels_per_unit = proj[1][1] * 0.5f * static_cast<float>(render_res.h);
+		m_RenderQueue.Build(s_SceneStack.top()->GetSceneEntities(), m_Visibility, m_Meshes, scene_cam.pos, scene_cam.front, pixels_per_unit, m_LodBias);
+		m_InstanceBuff.BuildBatches(m_RenderQueue, s_SceneStack.top()->GetSceneEntities());
+		m_LightBuff.Gather(s_SceneStack.top()->GetSceneEntities());
+
+		// Only text fields that changed since last frame get rebuilt, the rest stay resident in the UI buffer
+		ui_layer.BeginFrame(s_SceneStack.top()->GetSceneID(), s_SceneStack.top()->GetSceneUITextFields());
+		ui_layer.UpdateTextCache(s_Device, s_SceneStack.top()->GetSceneUITextFields(), test_font, s_Resolution);
+		m_Bench.MarkStage(BenchStage::BENCH_STAGE_PREPARE);
+
+		SDL_GPUCopyPass* frame_copy_pass = SDL_BeginGPUCopyPass(cmd_buff);
+		m_RenderStats.bytes_uploaded += m_InstanceBuff.Upload(s_Device, frame_copy_pass);
+		m_RenderStats.bytes_uploaded += m_LightBuff.Upload(s_Device, frame_copy_pass);
+		m_RenderStats.bytes_uploaded += ui_layer.EndFrame(s_Device, frame_copy_pass, m_UIBuff);
+		SDL_EndGPUCopyPass(frame_copy_pass);
+		m_Bench.MarkStage(BenchStage::BENCH_STAGE_UPLOAD);
+
+		// Bin this frame's lights into view space clusters before anything is shaded
+		m_LightBuff.CullLights(cmd_buff, m_PipelineLightCull, scene_view, proj, render_res);
+
+		// At full scale opaque geometry, skybox and UI all draw into the swapchain and share the depth buffer, the graph runs them as one render pass
+		// The swapchain comes back with undefined contents and gets presented, depth never outlives the frame
+		m_RenderGraph.Reset();
+		Uint32 backbuffer_res = m_RenderGraph.ImportTexture(swapchain_tex, false, true);
+		Uint32 depth_res = m_RenderGraph.ImportTexture(m_Textures[DEPTH_TEXTURE_IDX], false, false);
+
+		// A scaled scene goes to the offscreen target first and is stretched onto the swapchain before the UI
+		Uint32 scene_res = is_scaled ? m_RenderGraph.ImportTexture(m_Textures[SCENE_COLOR_TEXTURE_IDX], false, false) : backbuffer_res;
+		SDL_GPUViewport scene_viewport = { 0.0f, 0.0f, static_cast<float>(render_res.w), static_cast<float>(render_res.h), 0.0f, 1.0f };
+		SDL_Rect scene_scissor = { 0, 0, static_cast<int>(render_res.w), static_cast<int>(render_res.h) };
+
+		// Stage 1: 3D Models
+		// Every model samples the material array, the per instance layer picks the texture
+		Uint32 opaque_pass = m_RenderGraph.AddPass("Opaque", scene_res, RG_ACCESS_CLEAR, depth_res, RG_ACCESS_CLEAR,
+			[&](SDL_GPUCommandBuffer* pass_cmd_buff, SDL_GPURenderPass* render_pass_models)
+			{
+				SDL_SetGPUViewport(render_pass_models, &scene_viewport);
+				SDL_SetGPUScissor(render_pass_models, &scene_scissor);
 
-			mvp = proj * s_SceneStack.top()->GetSceneCamera().GetViewMatrix() * current_entity.GetTransformMatrix();
-			SDL_PushGPUVertexUniformData(cmd_buff, 0, glm::value_ptr(mvp), sizeof(mvp));
-			current_entity.Draw(render_pass_models, { m_Meshes[current_entity.mesh_type].vbo, 0 }, { m_Meshes[current_entity.mesh_type].ibo, 0 }, { m_Textures[current_entity.texture_type], m_Sampler }, m_Meshes[current_entity.mesh_type].ind_count);
-			light_positions[light_count] = current_entity.GetTransformMatrix() * origin;
-			light_count++;
-		}
+				RenderStateCache state_cache;
+				state_cache.Begin(render_pass_models, &m_RenderStats);
+				SDL_GPUGraphicsPipeline* pipelines[RenderPipelineID::RENDERPIPELINE_MAX] = { m_PipelineModelsNoPhong, m_PipelineModelsPhong };
 
-		SDL_BindGPUGraphicsPipeline(render_pass_models, m_PipelineModelsPhong);
+				// view projection | instance base | 3xpad
+				struct
+				{
+					glm::mat4 view_proj;
+					Uint32 instance_base;
+					Uint32 pad[3];
+				} v_ubo = {};
+				v_ubo.view_proj = proj * scene_view;
+
+				// object color | pad
+				// view pos | pad
+				// view
+				// cluster info
+				struct
+				{
+					glm::vec3 object_color_base;
+					float pad0;
+					glm::vec3 view_pos;
+					float pad1;
+					glm::mat4 view;
+					ClusterInfo cluster_info;
+				} f_ubo = {};
+				f_ubo.object_color_base = glm::vec3(0.97f, 0.64f, 0.12f);
+				f_ubo.view_pos = scene_cam.pos;
+				f_ubo.view = scene_view;
+				f_ubo.cluster_info = m_LightBuff.cluster_info;
+
+				// Every mesh lives in the geometry pool, batches only move the base vertex and first index
+				state_cache.BindVertexBuffer(m_GeometryPool.vbo);
+				state_cache.BindIndexBuffer(m_GeometryPool.ibo, m_GeometryPool.index_size);
+
+				for (InstanceBatch& batch : m_InstanceBuff.batches)
+				{
+					if (state_cache.BindPipeline(pipelines[batch.pipeline]) && batch.pipeline == RenderPipelineID::MODELS_PHONG)
+					{
+						// Lights and clusters are the same for every shaded batch so they are bound once
+						SDL_GPUBuffer* light_binds[3] = { m_LightBuff.light_buff, m_LightBuff.cluster_count_buff, m_LightBuff.cluster_index_buff };
+						SDL_BindGPUFragmentStorageBuffers(render_pass_models, 0, light_binds, 3);
+						SDL_PushGPUFragmentUniformData(pass_cmd_buff, 0, &f_ubo, sizeof(f_ubo));
+					}
+
+					state_cache.BindVertexStorageBuffer(m_InstanceBuff.storage_buff);
+					state_cache.BindFragmentSampler({ m_Textures[MATERIAL_ARRAY_IDX], m_MaterialSampler });
+
+					Mesh& batch_mesh = m_Meshes[batch.mesh_type];
+					MeshLod& batch_lod = batch_mesh.lods[batch.lod];
+
+					v_ubo.instance_base = batch.first_instance;
+					SDL_PushGPUVertexUniformData(pass_cmd_buff, 0, &v_ubo, sizeof(v_ubo));
+					SDL_DrawGPUIndexedPrimitives(render_pass_models, batch_lod.ind_count, batch.instance_count, batch_mesh.first_index + batch_lod.first_index, batch_mesh.base_vertex, 0);
+					m_RenderStats.draw_calls++;
+				}
+			}
+		);
 
-		// Shaded Objects
-		for (Entity& current_entity : s_SceneStack.top()->GetSceneEntities())
-		{
-			if (!current_entity.is_shaded)
-				continue;
-			if (!current_entity.is_active)
-				continue;
+		// Stage 2: Skybox
+		// Drawn at the far plane after the opaque geometry, so the depth test rejects every covered pixel before shading
+		Uint32 skybox_pass = m_RenderGraph.AddPass("Skybox", scene_res, RG_ACCESS_WRITE, depth_res, RG_ACCESS_READ,
+			[&](SDL_GPUCommandBuffer* pass_cmd_buff, SDL_GPURenderPass* render_pass_skybox)
+			{
+				SDL_SetGPUViewport(render_pass_skybox, &scene_viewport);
+				SDL_SetGPUScissor(render_pass_skybox, &scene_scissor);
+				SDL_BindGPUGraphicsPipeline(render_pass_skybox, m_PipelineSkybox);
+				SkyboxSlot& skybox = m_Skyboxes.GetDisplayed();
+				SDL_GPUTextureSamplerBinding skybox_bind = { skybox.texture, m_SkyboxSampler };
+				SDL_BindGPUFragmentSamplers(render_pass_skybox, 0, &skybox_bind, 1);
+				// Greyscale skyboxes are baked to a single channel and expanded back in the shader
+				Uint32 skybox_channels[4] = { static_cast<Uint32>(skybox.props.channels) };
+				SDL_PushGPUFragmentUniformData(pass_cmd_buff, 0, skybox_channels, sizeof(skybox_channels));
+				glm::mat4 vp_sky(1.0f);
+				glm::mat4 view_no_transform = glm::mat4(glm::mat3(scene_view));
+				vp_sky = proj * view_no_transform;
+				SDL_PushGPUVertexUniformData(pass_cmd_buff, 0, glm::value_ptr(vp_sky), sizeof(vp_sky));
+				SDL_DrawGPUPrimitives(render_pass_skybox, 36, 1, 0, 0);
+				m_RenderStats.draw_calls++;
+			}
+		);
+		m_RenderGraph.AddDependency(skybox_pass, opaque_pass);
+		Uint32 scene_done_pass = skybox_pass;
 
-			mvp = proj * s_SceneStack.top()->GetSceneCamera().GetViewMatrix() * current_entity.GetTransformMatrix();
-			glm::mat4 v_ubo[2] = { current_entity.GetTransformMatrix(), mvp};
-			SDL_PushGPUVertexUniformData(cmd_buff, 0, glm::value_ptr(v_ubo[0]), sizeof(v_ubo));
-			// object color | pad
-			// light color | pad
-			// view pos | pad
-			// num of lights | 3xpad
-			// light pos array of vec4
-			float f_ubo[144] = {
-				0.97f, 0.64f, 0.12f, 0.0f,
-				1.0f, 1.0f, 1.0f, 0.0f,
-				s_SceneStack.top()->GetSceneCamera().pos.x, s_SceneStack.top()->GetSceneCamera().pos.y, s_SceneStack.top()->GetSceneCamera().pos.z, 0.0f,
-				static_cast<float>(light_count), 0.0f, 0.0f, 0.0f
-			};
-			std::memcpy(f_ubo + 16, light_positions, sizeof(light_positions));
-
-			SDL_PushGPUFragmentUniformData(cmd_buff, 0, &f_ubo, sizeof(f_ubo));
-			current_entity.Draw(render_pass_models, { m_Meshes[current_entity.mesh_type].vbo, 0}, { m_Meshes[current_entity.mesh_type].ibo, 0}, { m_Textures[current_entity.texture_type], m_Sampler}, m_Meshes[current_entity.mesh_type].ind_count);
+		// Stage 3: Upscale
+		// The blit overwrites the whole swapchain, so nothing from before it has to be loaded
+		if (is_scaled)
+		{
+			scene_done_pass = m_RenderGraph.AddBlit("Upscale", scene_res, backbuffer_res,
+				[&](SDL_GPUCommandBuffer* pass_cmd_buff, SDL_GPURenderPass*)
+				{
+					SDL_GPUBlitInfo blit_info = {};
+					blit_info.source.texture = m_Textures[SCENE_COLOR_TEXTURE_IDX];
+					blit_info.source.w = render_res.w;
+					blit_info.source.h = render_res.h;
+					blit_info.destination.texture = swapchain_tex;
+					blit_info.destination.w = s_Resolution.w;
+					blit_info.destination.h = s_Resolution.h;
+					blit_info.load_op = SDL_GPU_LOADOP_DONT_CARE;
+					blit_info.filter = SDL_GPU_FILTER_LINEAR;
+					SDL_BlitGPUTexture(pass_cmd_buff, &blit_info);
+				}
+			);
+			m_RenderGraph.AddDependency(scene_done_pass, skybox_pass);
 		}
 
-		SDL_EndGPURenderPass(render_pass_models);
+		// Stage 4: UI Layer
+		Uint32 ui_pass = m_RenderGraph.AddPass("UI", backbuffer_res, RG_ACCESS_WRITE, depth_res, RG_ACCESS_NONE,
+			[&](SDL_GPUCommandBuffer* pass_cmd_buff, SDL_GPURenderPass* render_pass_ui)
+			{
+				SDL_BindGPUGraphicsPipeline(render_pass_ui, m_PipelineUI);
 
-		// Stage 3: UI Layer
-		for (UI_TextField text_field : s_SceneStack.top()->GetSceneUITextFields())
-		{
-			if(text_field.is_visible)
-				ui_layer.PushTextToUIBuff(s_Device, m_UIBuff, text_field, test_font, s_Resolution);
-		}
+				SDL_GPUBufferBinding test_bind = { m_UIBuff, 0 };
+				SDL_BindGPUVertexBuffers(render_pass_ui, 0, &test_bind, 1);
+				SDL_GPUTextureSamplerBinding testtex_bind = { test_font.atlas_texture, m_UISampler };
+				SDL_BindGPUFragmentSamplers(render_pass_ui, 0, &testtex_bind, 1);
 
-		SDL_GPURenderPass* render_pass_ui = SDL_BeginGPURenderPass(
-			cmd_buff,
-			&color_target_info,
-			1,
-			nullptr
+				SDL_PushGPUVertexUniformData(pass_cmd_buff, 0, glm::value_ptr(proj_ui), sizeof(proj_ui));
+				SDL_DrawGPUPrimitives(render_pass_ui, ui_layer.frame_offset / sizeof(UIVertex), 1, 0, 0);
+				m_RenderStats.draw_calls++;
+			}
 		);
-		if (!render_pass_ui) {
-			SDL_LogCritical(SDL_LOG_CATEGORY_APPLICATION, "Failed to begin UI render pass: %s", SDL_GetError());
-			std::abort();
-		}
-		SDL_BindGPUGraphicsPipeline(render_pass_ui, m_PipelineUI);
+		m_RenderGraph.AddDependency(ui_pass, scene_done_pass);
 
-		SDL_GPUBufferBinding test_bind = { m_UIBuff, 0 };
-		SDL_BindGPUVertexBuffers(render_pass_ui, 0, &test_bind, 1);
-		SDL_GPUTextureSamplerBinding testtex_bind = { test_font.atlas_texture, m_Sampler };
-		SDL_BindGPUFragmentSamplers(render_pass_models, 0, &testtex_bind, 1);
+		m_RenderStats.render_passes = m_RenderGraph.Execute(cmd_buff);
+		ui_layer.FlushUIBuff(s_Device);
+		m_Bench.MarkStage(BenchStage::BENCH_STAGE_RECORD);
 
-		SDL_PushGPUVertexUniformData(cmd_buff, 0, glm::value_ptr(proj_ui), sizeof(proj_ui));
-		SDL_DrawGPUPrimitives(render_pass_ui, ui_layer.frame_offset / sizeof(Vertex), 1, 0, 0);
+		SDL_LogDebug(SDL_LOG_CATEGORY_RENDER, "Frame: %u visible, %u culled, %u draw calls in %u render passes\n", m_RenderStats.entities_visible, m_RenderStats.entities_culled, m_RenderStats.draw_calls, m_RenderStats.render_passes);
 
+		BB3D_PROFILE_ZONE("SubmitCommandBuffer");
+		if (m_Bench.is_enabled)
+		{
+			// Nothing throttles a headless frame, so wait on the GPU here and report it as its own stage
+			SDL_GPUFence* frame_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cmd_buff);
+			if (!frame_fence)
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit command buffer to GPU: %s\n", SDL_GetError());
+				std::abort();
+			}
+			m_Bench.MarkStage(BenchStage::BENCH_STAGE_SUBMIT);
 
-		SDL_EndGPURenderPass(render_pass_ui);
-		ui_layer.FlushUIBuff(s_Device);
+			SDL_WaitForGPUFences(s_Device, true, &frame_fence, 1);
+			SDL_ReleaseGPUFence(s_Device, frame_fence);
+			m_Bench.MarkStage(BenchStage::BENCH_STAGE_GPU_WAIT);
+			return;
+		}
 
 		if (!SDL_SubmitGPUCommandBuffer(cmd_buff))
 		{
@@ -438,17 +645,45 @@ namespace BB3D
 		}
 	}
 
+	// Fixed frame count with one simulation tick per frame, no input and no pacing
+	void Engine::RunBenchmark()
+	{
+		SDL_Log("OK: Benchmarking %s for %u frames after %u warmup frames\n", m_Bench.scene_path.c_str(), m_Bench.frame_count, m_Bench.warmup_count);
+
+		const float tick_delta = m_Timer.GetTickDelta();
+		m_Bench.frames.reserve(m_Bench.warmup_count + m_Bench.frame_count);
+		for (Uint32 frame_idx = 0; frame_idx < m_Bench.warmup_count + m_Bench.frame_count; frame_idx++)
+		{
+			BB3D_PROFILE_ZONE("Frame");
+			m_Bench.BeginFrame();
+
+			Scene* current_scene = s_SceneStack.top().get();
+			for (Entity& current_entity : current_scene->GetSceneEntities())
+				current_entity.StorePrevState();
+			current_scene->Update(m_InputState, tick_delta);
+			m_Bench.MarkStage(BenchStage::BENCH_STAGE_UPDATE);
+
+			Render();
+			m_Bench.EndFrame(m_RenderStats);
+		}
+
+		m_Bench.WriteReport(SDL_GetGPUDeviceDriver(s_Device), s_Resolution, s_DynamicRes.GetRenderResolution(s_Resolution));
+	}
+
 	void Engine::Input()
 	{
+		BB3D_PROFILE_FUNCTION();
 		// Free Camera code is debug only and will be gone at some point
 		// TODO Clean up Camera Code
 		float mouse_sensitivity = 0.3f;
-		m_InputState.relx = 0;
-		m_InputState.rely = 0;
 
 		SDL_Event ev;
 		while (SDL_PollEvent(&ev))
 		{
+			// A replay owns the input state, only quitting is still honoured
+			if (m_InputReplay.mode == ReplayMode::REPLAY_PLAYBACK && ev.type != SDL_EVENT_QUIT)
+				continue;
+
 			switch (ev.type)
 			{
 				case SDL_EVENT_QUIT:
@@ -459,8 +694,9 @@ namespace BB3D
 
 				case SDL_EVENT_MOUSE_MOTION:
 				{
-					m_InputState.relx = ev.motion.xrel * mouse_sensitivity;
-					m_InputState.rely = ev.motion.yrel * mouse_sensitivity;
+					// Accumulated until the next simulation tick consumes it
+					m_InputState.relx += ev.motion.xrel * mouse_sensitivity;
+					m_InputState.rely += ev.motion.yrel * mouse_sensitivity;
 					m_InputState.current_mouse_x = (ev.motion.x/s_Resolution.w) * 16;
 					m_InputState.current_mouse_y = (ev.motion.y/s_Resolution.h) * 9;
 					break;
@@ -468,6 +704,10 @@ namespace BB3D
 
 				case SDL_EVENT_KEY_DOWN:
 				{
+					// Profiler trace on demand, does nothing unless BB3D_PROFILE is defined
+					if (ev.key.scancode == SDL_SCANCODE_F10 && !ev.key.repeat)
+						BB3D_PROFILE_DUMP("bb3d_trace.json");
+
 					RecordKeyState(ev.key.scancode, true);
 					break;
 				}
@@ -515,13 +755,13 @@ namespace BB3D
 			{
 				SDL_HideCursor();
 				SDL_SetWindowRelativeMouseMode(s_Window, true);
-				s_SceneStack.push(std::make_unique<GameScene>("assets/scenes/gameplay.json", SceneTransToCallback));
+				s_SceneStack.push(std::make_unique<GameScene>("assets/scenes/gameplay.bb3dscene", SceneTransToCallback));
 				break;
 			}
 
 			case SceneType::OPTIONS:
 			{
-				s_SceneStack.push(std::make_unique<OptionsScene>("assets/scenes/optionsmenu.json", SceneTransToCallback, OptionsToggleSkyboxCallback));
+				s_SceneStack.push(std::make_unique<OptionsScene>("assets/scenes/optionsmenu.bb3dscene", SceneTransToCallback, OptionsToggleSkyboxCallback, OptionsCycleResolutionCallback, s_DynamicRes.GetLabel()));
 				break;
 			}
 		}
@@ -532,11 +772,17 @@ namespace BB3D
 		int tex_idx = static_cast<int>(s_SelectedTex);
 
 		tex_idx += 1;
-		if (tex_idx >= TextureType::TEXTURETYPE_MAX) tex_idx = 12;
+		if (tex_idx >= TextureType::TEXTURETYPE_MAX) tex_idx = TextureType::SPACE_SKYBOX;
 
 		s_SelectedTex = static_cast<TextureType>(tex_idx);
 	}
 
+	std::string Engine::OptionsCycleResolutionCallback()
+	{
+		s_DynamicRes.CycleMode();
+		return s_DynamicRes.GetLabel();
+	}
+
 	void Engine::RecordKeyState(SDL_Keycode keycode, bool is_keydown)
 	{
 		if (keycode < 0 || keycode >= 128) 
@@ -557,25 +803,94 @@ namespace BB3D
 
 	void Engine::CopyPrevInput()
 	{
+		BB3D_PROFILE_FUNCTION();
 		std::memcpy(m_InputState.prev_keys, m_InputState.current_keys, sizeof(m_InputState.current_keys));
 		std::memcpy(m_InputState.prev_mousebtn, m_InputState.current_mousebtn, sizeof(m_InputState.current_mousebtn));
 		m_InputState.prev_mouse_x = m_InputState.current_mouse_x;
 		m_InputState.prev_mouse_y = m_InputState.current_mouse_y;
+		m_InputState.relx = 0;
+		m_InputState.rely = 0;
 	}
 
 	void Engine::UpdateDeltaTime()
 	{
-		const float FRAME_TARGET_TIME = 1.0f / 60.0f;
-
-		m_Timer.last_frame = m_Timer.current_frame;
-		m_Timer.current_frame = SDL_GetTicks();
-		m_Timer.elapsed_time = (m_Timer.current_frame - m_Timer.last_frame) / 1000.0f;
+		BB3D_PROFILE_FUNCTION();
+		m_Timer.LimitFrame();
+		m_Timer.Tick();
+		s_DynamicRes.Update(m_Timer.GetFrameCostMs());
 
-		if (m_Timer.elapsed_time < FRAME_TARGET_TIME) SDL_Delay((FRAME_TARGET_TIME - m_Timer.elapsed_time) * 1000.0f);
+		if (m_Timer.frame_times_head == 0)
+		{
+			FrameStats frame_stats = m_Timer.GetFrameStats();
+			SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Frame time: %.3fms avg, %.3fms p99, %.3fms max, %llu missed deadlines\n",
+				frame_stats.avg_ms, frame_stats.p99_ms, frame_stats.max_ms, static_cast<unsigned long long>(frame_stats.missed_deadlines));
+		}
 	}
 
 	void Engine::ParseSettingsJSON()
 	{
 		const char* SETTINGS_PATH = "bb3d_settings.json";
+
+		// Missing settings are not fatal, the defaults are 60 FPS with vsync and a 120Hz simulation
+		Uint32 target_fps = 60;
+		bool is_vsync = true;
+		Uint32 tick_rate = 120;
+		Uint32 max_ticks_per_frame = 8;
+		Uint32 skybox_budget_mb = 16;
+		Uint32 anisotropy = 8;
+		float lod_bias = 0.0f;
+		float render_scale = 1.0f;
+		bool is_dynamic_res = false;
+
+		std::ifstream settings_f(SETTINGS_PATH);
+		if (settings_f)
+		{
+			nlohmann::json settings_data = nlohmann::json::parse(settings_f, nullptr, false);
+			if (settings_data.is_discarded())
+			{
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to parse settings json at: %s, using defaults\n", SETTINGS_PATH);
+			}
+			else
+			{
+				// 0 is uncapped
+				target_fps = settings_data.value("target_fps", target_fps);
+				is_vsync = settings_data.value("vsync", is_vsync);
+				tick_rate = settings_data.value("tick_rate", tick_rate);
+				max_ticks_per_frame = settings_data.value("max_ticks_per_frame", max_ticks_per_frame);
+				skybox_budget_mb = settings_data.value("skybox_vram_budget_mb", skybox_budget_mb);
+				anisotropy = settings_data.value("anisotropy", anisotropy);
+				// Positive trades detail for fewer triangles, negative holds the full meshes further out
+				lod_bias = settings_data.value("lod_bias", lod_bias);
+				// Fraction of the window the 3D scene renders at, dynamic lets frame cost pick it
+				render_scale = settings_data.value("render_scale", render_scale);
+				is_dynamic_res = settings_data.value("dynamic_resolution", is_dynamic_res);
+			}
+		}
+		else
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to locate settings json at: %s, using defaults\n", SETTINGS_PATH);
+		}
+
+		m_Timer.SetTargetRate(target_fps);
+		m_Timer.SetTickRate(tick_rate, max_ticks_per_frame);
+		m_SkyboxBudget = static_cast<Uint64>(skybox_budget_mb) * 1024 * 1024;
+		m_Anisotropy = static_cast<Uint8>(SDL_min(anisotropy, 16u));
+		m_LodBias = lod_bias;
+		// Uncapped still aims for 60, otherwise the controller has no budget to steer towards
+		s_DynamicRes.Init(render_scale, is_dynamic_res, 1000.0f / static_cast<float>(target_fps ? target_fps : 60));
+
+		// Without vsync the limiter alone paces frames, which is what allows 120/144 on a 60Hz display
+		if (!is_vsync && s_Window)
+		{
+			SDL_GPUPresentMode present_mode = SDL_GPU_PRESENTMODE_IMMEDIATE;
+			if (SDL_WindowSupportsGPUPresentMode(s_Device, s_Window, SDL_GPU_PRESENTMODE_MAILBOX))
+				present_mode = SDL_GPU_PRESENTMODE_MAILBOX;
+
+			if (!SDL_WindowSupportsGPUPresentMode(s_Device, s_Window, present_mode) ||
+				!SDL_SetGPUSwapchainParameters(s_Device, s_Window, SDL_GPU_SWAPCHAINCOMPOSITION_SDR, present_mode))
+			{
+				SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to disable vsync, keeping the default present mode\n");
+			}
+		}
 	}
 }
\ No newline at end of file
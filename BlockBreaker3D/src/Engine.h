@@ -8,10 +8,21 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <atomic>
+#include <unordered_map>
 #include "Camera.h"
+#include "MeshFormat.h"
+#include "TextureFormat.h"
 
 #define DEPTH_TEXTURE_IDX 0
-#define SKYBOX_TEXTURE_IDX 0xC
+#define MATERIAL_ARRAY_IDX 0x1
+#define SCENE_COLOR_TEXTURE_IDX 0x2
+#define FRAME_STATS_WINDOW 240
+#define SAMPLER_LOD_UNCLAMPED 1000.0f
 
 namespace BB3D
 {
@@ -43,14 +54,52 @@ namespace BB3D
 		QUAD = 0x1,
 		SPHERE = 0x2,
 		PADDLE = 0x3,
-		BLOCK = 0x4
+		BLOCK = 0x4,
+		MESHTYPE_MAX = 0x5
 	};
 
+	struct FrameStats
+	{
+		float avg_ms;
+		float p99_ms;
+		float max_ms;
+		Uint64 missed_deadlines;
+	};
+
+	// ________________________________ Timer.cpp ________________________________
 	struct Timer
 	{
-		Uint64 last_frame;
-		Uint64 current_frame;
-		float elapsed_time;
+		Uint64 last_frame;		// ns
+		Uint64 current_frame;	// ns
+		float elapsed_time;		// seconds
+
+		// Frame limiter, a target frame time of 0 is uncapped
+		Uint64 target_frame_time = 0;	// ns
+		Uint64 next_deadline = 0;		// ns
+		Uint64 missed_deadlines = 0;
+		Uint64 limiter_wait_time = 0;	// ns spent sleeping or spinning in the last LimitFrame
+		Uint64 present_wait_time = 0;	// ns blocked acquiring the swapchain texture, set by the renderer
+
+		// Rolling window of the most recent frame times in ns
+		std::array<Uint64, FRAME_STATS_WINDOW> frame_times = {};
+		Uint32 frame_times_head = 0;
+		Uint32 frame_times_count = 0;
+
+		// Fixed simulation step, whatever is left in the accumulator becomes the render interpolation factor
+		Uint64 tick_time = 0;			// ns
+		Uint64 tick_accumulator = 0;	// ns
+		Uint32 max_ticks_per_frame = 0;
+
+		void Start();
+		void SetTargetRate(Uint32 target_fps);
+		void SetTickRate(Uint32 tick_rate, Uint32 max_ticks);
+		void LimitFrame();
+		void Tick();
+		bool ConsumeTick();
+		float GetTickDelta();
+		float GetTickAlpha();
+		float GetFrameCostMs();
+		FrameStats GetFrameStats();
 	};
 
 	struct InputState
@@ -70,8 +119,117 @@ namespace BB3D
 		unsigned int h;
 	};
 
+	// ________________________________ DynamicResolution.cpp ________________________________
+	enum RenderScaleMode : Uint8
+	{
+		RENDER_SCALE_FIXED = 0x0,
+		RENDER_SCALE_DYNAMIC = 0x1
+	};
+
+	// Fraction of the window the 3D passes render at, fixed from settings or steered by frame cost
+	struct DynamicResolution
+	{
+		RenderScaleMode mode = RenderScaleMode::RENDER_SCALE_FIXED;
+		float scale = 1.0f;
+		float fixed_scale = 1.0f;
+		float target_ms = 16.667f;
+		float smoothed_ms = 0.0f;
+		Uint32 cooldown = 0;
+
+	public:
+		void Init(float new_fixed_scale, bool is_dynamic, float new_target_ms);
+		void Update(float frame_cost_ms);
+		void CycleMode();
+		Resolution GetRenderResolution(Resolution native_res);
+		std::string GetLabel();
+	};
+
 	// OUTSIDE SOURCE FILES
-// ________________________________ Shader.cpp ________________________________
+	// ________________________________ Random.cpp ________________________________
+	// Small seeded generator (PCG32) so a recorded seed reproduces every roll in a replay
+	struct Random
+	{
+		Uint64 state;
+		Uint64 increment;
+
+		void Seed(Uint64 seed);
+		Uint32 Next();
+		float NextFloat(); // [0, 1)
+	};
+
+	// ________________________________ Replay.cpp ________________________________
+	enum ReplayMode : Uint8
+	{
+		REPLAY_OFF,
+		REPLAY_RECORD,
+		REPLAY_PLAYBACK
+	};
+
+	// File layout, little endian
+	// Header: magic "BB3R" | version (2) | tick rate (4) | seed (8)
+	// Ticks: flags (1) | state hash (4) | [toggled key count (1) | scancodes] | [toggled button count (1) | buttons] | [mouse x, y (8)] | [rel x, y (8)]
+	// The state hash is of the scene as the tick starts, playback compares it to catch the first tick that diverges
+	struct InputReplay
+	{
+		ReplayMode mode = ReplayMode::REPLAY_OFF;
+		std::string filepath;
+		Uint64 seed = 0;
+		Uint32 tick_rate = 0;
+
+		// Recording streams out in chunks of about a second, playback holds the whole file
+		std::vector<Uint8> stream;
+		SDL_IOStream* record_file = nullptr;
+		Uint64 record_size = 0;
+		size_t read_offset = 0;
+		Uint32 tick_count = 0;
+		bool is_desynced = false;
+
+		// State as of the last recorded tick, ticks only store what changed since
+		InputState last_state = {};
+
+		void BeginRecording(const char* path, Uint64 record_seed, Uint32 record_tick_rate);
+		void RecordTick(const InputState& input_state, Uint32 state_hash);
+		void FlushRecording();
+		void EndRecording();
+		void BeginPlayback(const char* path);
+		bool PlaybackTick(InputState& input_state, Uint32 state_hash);
+	};
+
+	// ________________________________ Profiler.cpp ________________________________
+	// Scoped CPU zones written into per thread rings, dumped as Chrome trace JSON (chrome://tracing, Perfetto)
+	// Everything below is compiled out unless BB3D_PROFILE is defined, which CMake only does for Debug builds
+#ifdef BB3D_PROFILE
+	struct ProfileZone
+	{
+		const char* name;
+		Uint64 start_ns;
+		Uint64 end_ns;
+	};
+
+	struct ProfileScope
+	{
+		const char* name;
+		Uint64 start_ns;
+
+		ProfileScope(const char* zone_name);
+		~ProfileScope();
+	};
+
+	void ProfilerRecordZone(const char* name, Uint64 start_ns, Uint64 end_ns);
+	void ProfilerDumpChromeTrace(const char* filepath);
+
+#define BB3D_PROFILE_JOIN_INNER(a, b) a##b
+#define BB3D_PROFILE_JOIN(a, b) BB3D_PROFILE_JOIN_INNER(a, b)
+#define BB3D_PROFILE_ZONE(name) BB3D::ProfileScope BB3D_PROFILE_JOIN(profile_zone_, __LINE__)(name)
+#define BB3D_PROFILE_FUNCTION() BB3D_PROFILE_ZONE(__FUNCTION__)
+#define BB3D_PROFILE_DUMP(filepath) BB3D::ProfilerDumpChromeTrace(filepath)
+#else
+#define BB3D_PROFILE_ZONE(name) ((void)0)
+#define BB3D_PROFILE_FUNCTION() ((void)0)
+#define BB3D_PROFILE_DUMP(filepath) ((void)0)
+#endif
+
+	// ________________________________ Shader.cpp ________________________________
 	SDL_GPUShader* CreateShaderFromFile(
 		SDL_GPUDevice* device,
 		const char* file_path,
@@ -81,39 +239,227 @@ namespace BB3D
 		Uint32 storage_buffer_count,
 		Uint32 storage_texture_count
 	);
+	SDL_GPUComputePipeline* CreateComputePipelineFromFile(
+		SDL_GPUDevice* device,
+		const char* file_path,
+		Uint32 readonly_storage_buffer_count,
+		Uint32 readwrite_storage_buffer_count,
+		Uint32 uniform_buffer_count,
+		Uint32 threadcount_x
+	);
+
+	// ________________________________ FileMapping.cpp ________________________________
+	// Read only view of a whole file, pages are faulted in by the OS as they are touched
+	struct MappedFile
+	{
+		const Uint8* data = nullptr;
+		size_t size = 0;
+
+		// Win32 handles, unused on POSIX
+		void* file_handle = nullptr;
+		void* mapping_handle = nullptr;
+
+	public:
+		bool Open(const char* filepath);
+		void Close();
+	};
+
+	// ________________________________ GeometryPool.cpp ________________________________
+	// Every mesh suballocated out of one vertex and one index buffer, so a pass binds geometry once
+	// Indices stay local to their mesh and draws add the base vertex, 16 bit unless some mesh needs 32
+	struct GeometryPool
+	{
+		SDL_GPUBuffer* vbo = nullptr;
+		SDL_GPUBuffer* ibo = nullptr;
+		SDL_GPUIndexElementSize index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+		Uint32 vertex_capacity = 0;
+		Uint32 index_capacity = 0;
+		Uint32 vertex_count = 0;
+		Uint32 index_count = 0;
+
+	public:
+		void Init(SDL_GPUDevice* device, Uint32 new_vertex_capacity, Uint32 new_index_capacity, SDL_GPUIndexElementSize new_index_size);
+		bool Allocate(Uint32 vert_count, Uint32 ind_count, Uint32& out_base_vertex, Uint32& out_first_index);
+		Uint32 GetIndexStride();
+		void Release(SDL_GPUDevice* device);
+	};
 
 	// ________________________________ Mesh.cpp ________________________________
+	// A range of the mesh's index buffer, coarser levels reuse the same vertices
+	struct MeshLod
+	{
+		Uint32 first_index;
+		Uint32 ind_count;
+		float error; // object units, RMS estimate of how far the surface drifts from the full mesh, not a bound
+	};
+
 	struct Mesh
 	{
-		SDL_GPUBuffer* vbo;
-		SDL_GPUBuffer* ibo;
+		// Where the mesh sits in the GeometryPool, LOD ranges are relative to first_index
+		Sint32 base_vertex;
+		Uint32 first_index;
 		int vert_count;
-		int ind_count;
+		MeshLod lods[BAKED_MESH_MAX_LODS];
+		Uint32 lod_count;
+
+		// Object space bounds, computed at load
+		glm::vec3 aabb_min;
+		glm::vec3 aabb_max;
+		glm::vec3 sphere_center;
+		float sphere_radius;
 	};
 
-	struct Vertex
+
+	// A baked mesh on its way to the GPU, see AssetBatch
+	struct MeshAsset
 	{
-		float v[8];
+		std::string filepath;
+		MappedFile file;
+		BakedMeshHeader header = {};
+		Uint32 staging_offset = 0;
+		GeometryPool* geometry_pool = nullptr;
+		Mesh mesh = {};
 
-		float& operator[](size_t i)
-		{
-			return v[i];
-		}
+	public:
+		void Read();
+		void Allocate(GeometryPool& pool);
+		Uint32 GetStagingSize();
+		void Stage(Uint8* staging_ptr);
+		void Upload(SDL_GPUCopyPass* copy_pass, SDL_GPUTransferBuffer* trans_buff);
 	};
 
-	Mesh LoadMeshFromFile(SDL_GPUDevice* device, const char* filepath);
-	Mesh CreateMesh(SDL_GPUDevice* device, std::vector<Vertex> vertices, std::vector<Uint16> indices);
-
 	// ________________________________ Texture.cpp ________________________________
 	struct Image
 	{
 		int x, y, channels;
 	};
 
-	SDL_GPUTexture* CreateAndLoadCubeMapToGPU(SDL_GPUDevice* device, std::array<std::string, 6> filepaths);
+	// A baked texture on its way to the GPU, see AssetBatch
+	struct TextureAsset
+	{
+		std::string filepath;
+		MappedFile file;
+		BakedTextureHeader header = {};
+		const BakedTextureSubresource* subresources = nullptr;
+		BakedTextureFormat upload_format = BAKED_FORMAT_RGBA8;
+		Uint32 staging_offset = 0;
+		SDL_GPUTexture* texture = nullptr;
+		Image props = {};
+
+	public:
+		void Read();
+		void SelectUploadFormat(SDL_GPUDevice* device);
+		Uint32 GetStagingSize();
+		void CreateTexture(SDL_GPUDevice* device);
+		void Stage(Uint8* staging_ptr);
+		void Upload(SDL_GPUCopyPass* copy_pass, SDL_GPUTransferBuffer* trans_buff);
+	};
+
 	SDL_GPUTexture* CreateDepthTestTexture(SDL_GPUDevice* device, int render_target_w, int render_target_h);
-	SDL_GPUTexture* CreateAndLoadTextureToGPU(SDL_GPUDevice* device, const char* filepath);
-	SDL_GPUSampler* CreateSampler(SDL_GPUDevice* device, SDL_GPUFilter texture_filter);
+	SDL_GPUTexture* CreateColorTargetTexture(SDL_GPUDevice* device, SDL_GPUTextureFormat format, int render_target_w, int render_target_h);
+
+	struct SamplerDesc
+	{
+		SDL_GPUFilter filter = SDL_GPU_FILTER_NEAREST;
+		SDL_GPUSamplerMipmapMode mip_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
+		SDL_GPUSamplerAddressMode address_mode = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+		Uint8 max_anisotropy = 0; // 0 or 1 is off, up to 16
+
+	public:
+		Uint32 GetKey() const;
+	};
+
+	// Identical descriptions share one sampler for the lifetime of the device
+	struct SamplerCache
+	{
+		std::unordered_map<Uint32, SDL_GPUSampler*> samplers;
+
+	public:
+		SDL_GPUSampler* Get(SDL_GPUDevice* device, const SamplerDesc& desc);
+		void Release(SDL_GPUDevice* device);
+	};
+
+	// ________________________________ ThreadPool.cpp ________________________________
+	struct ThreadPool
+	{
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> jobs;
+		std::mutex jobs_mutex;
+		std::condition_variable jobs_cv;
+		std::condition_variable idle_cv;
+		Uint32 busy_count = 0;
+		bool is_stopping = false;
+
+	public:
+		void Init(Uint32 thread_count);
+		void Submit(std::function<void()> job);
+		// Blocks until the queue is drained and every worker is idle
+		void Wait();
+		void Shutdown();
+
+	private:
+		void WorkerLoop();
+	};
+
+	// ________________________________ Assets.cpp ________________________________
+	// Reads assets on the thread pool and uploads all of them through one staging buffer, one copy pass and one fence
+	struct AssetBatch
+	{
+		std::vector<MeshAsset> meshes;
+		std::vector<TextureAsset> textures;
+
+	public:
+		Uint32 AddMesh(const char* filepath);
+		Uint32 AddTexture(const char* filepath);
+		void Load(SDL_GPUDevice* device, ThreadPool& thread_pool, GeometryPool& geometry_pool);
+	};
+
+	// ________________________________ Skybox.cpp ________________________________
+	enum SkyboxLoadState : Uint8
+	{
+		SKYBOX_LOAD_IDLE = 0x0,
+		SKYBOX_LOAD_READING = 0x1,
+		SKYBOX_LOAD_STAGED = 0x2,
+	};
+
+	struct SkyboxSlot
+	{
+		std::string filepath;
+		SDL_GPUTexture* texture = nullptr;
+		Image props = {};
+		Uint32 vram_size = 0;
+		Uint64 last_used = 0;
+	};
+
+	// Keeps only the shown skybox guaranteed resident, the rest load in the background and are evicted LRU over budget
+	struct SkyboxCache
+	{
+		std::vector<SkyboxSlot> slots;
+		Uint64 vram_budget = 0;
+		Uint64 vram_resident = 0;
+		Uint64 use_counter = 0;
+		Uint32 displayed_idx = 0;
+		Uint32 requested_idx = 0;
+
+		// One background load at a time
+		Uint32 pending_idx = 0;
+		TextureAsset pending_asset;
+		std::vector<Uint8> pending_texels;
+		std::atomic<Uint8> pending_state = SKYBOX_LOAD_IDLE;
+
+	public:
+		void Init(const std::vector<std::string>& filepaths, Uint64 budget_bytes);
+		void AdoptTexture(Uint32 skybox_idx, TextureAsset& loaded_asset);
+		void Request(Uint32 skybox_idx);
+		void Update(SDL_GPUDevice* device, ThreadPool& thread_pool);
+		SkyboxSlot& GetDisplayed();
+		void Release(SDL_GPUDevice* device);
+
+	private:
+		void BeginLoad(SDL_GPUDevice* device, ThreadPool& thread_pool, Uint32 skybox_idx);
+		void FinishLoad(SDL_GPUDevice* device);
+		void EvictOverBudget(SDL_GPUDevice* device);
+	};
 
 	// ________________________________ GraphicsPipeline.cpp ________________________________
 	SDL_GPUGraphicsPipeline* CreateGraphicsPipelineForModels(SDL_GPUDevice* device, SDL_GPUTextureFormat color_target_format, SDL_GPUShader* vert_shader, SDL_GPUShader* frag_shader);
@@ -155,12 +501,297 @@ namespace BB3D
 		bool is_shaded;
 		bool is_active;
 
+		// State at the start of the current simulation tick, rendering blends towards the current state
+		glm::vec3 prev_position;
+		glm::vec3 prev_rotation;
+		glm::vec3 prev_scale;
+		bool has_prev_state = false;
+		glm::mat4 render_transform = glm::mat4(1.0f);
+
 		void UpdateTransform();
 		glm::mat4 GetTransformMatrix();
-		void Draw(SDL_GPURenderPass* render_pass, SDL_GPUBufferBinding vbo_bind, SDL_GPUBufferBinding ibo_bind, SDL_GPUTextureSamplerBinding tex_bind, int ind_count);
+		void StorePrevState();
+		void Interpolate(float alpha);
+		glm::mat4 GetRenderTransform();
+	};
+
+	// ________________________________ RenderQueue.cpp ________________________________
+	enum RenderPipelineID : Uint8
+	{
+		MODELS_NO_PHONG = 0x0,
+		MODELS_PHONG = 0x1,
+		RENDERPIPELINE_MAX = 0x2
+	};
+
+	// Sort key layout, most significant first
+	// Pipeline (4) | Mesh (8) | LOD (4) | Texture (8) | Depth (24) | Unused (16)
+	struct RenderItem
+	{
+		Uint64 sort_key;
+		Uint32 entity_idx;
+	};
+
+	struct RenderStats
+	{
+		Uint32 render_passes;
+		Uint32 draw_calls;
+		Uint32 binds_issued;
+		Uint32 binds_saved;
+		Uint32 entities_visible;
+		Uint32 entities_culled;
+		Uint32 bytes_uploaded;
+	};
+
+	struct RenderQueue
+	{
+		std::vector<RenderItem> items;
+
+		void Build(std::vector<Entity>& entities, std::vector<Uint8>& visibility, std::vector<Mesh>& meshes, glm::vec3 view_pos, glm::vec3 view_dir, float pixels_per_unit, float lod_bias);
+
+		static Uint8 SelectLod(const Mesh& mesh, float world_scale, float view_distance, float pixels_per_unit, float lod_bias);
+		static Uint64 MakeSortKey(RenderPipelineID pipeline, MeshType mesh, Uint8 lod, TextureType texture, float view_depth);
+		static RenderPipelineID GetPipeline(Uint64 sort_key);
+		static MeshType GetMesh(Uint64 sort_key);
+		static Uint8 GetLod(Uint64 sort_key);
+		static Uint64 GetStateBits(Uint64 sort_key);
+	};
+
+	// Remembers what is bound in the current render pass so redundant SDL_BindGPU* calls are skipped
+	struct RenderStateCache
+	{
+		SDL_GPURenderPass* render_pass = nullptr;
+		RenderStats* stats = nullptr;
+
+		SDL_GPUGraphicsPipeline* pipeline = nullptr;
+		SDL_GPUBuffer* vbo = nullptr;
+		SDL_GPUBuffer* ibo = nullptr;
+		SDL_GPUBuffer* vertex_storage_buff = nullptr;
+		SDL_GPUTextureSamplerBinding fragment_sampler = {};
+
+		void Begin(SDL_GPURenderPass* new_render_pass, RenderStats* frame_stats);
+		bool BindPipeline(SDL_GPUGraphicsPipeline* new_pipeline);
+		void BindVertexBuffer(SDL_GPUBuffer* new_vbo);
+		void BindIndexBuffer(SDL_GPUBuffer* new_ibo, SDL_GPUIndexElementSize index_size);
+		void BindVertexStorageBuffer(SDL_GPUBuffer* new_storage_buff);
+		void BindFragmentSampler(SDL_GPUTextureSamplerBinding new_sampler);
+	};
+
+	// ________________________________ Broadphase.cpp ________________________________
+	// Uniform grid over XZ holding entity indices, each entity lives in the cell under its center
+	// Queries widen by the entity half extent, so an entity is found from any cell its bounds reach
+	struct CollisionGrid
+	{
+		glm::vec2 origin = glm::vec2(0.0f);
+		glm::vec2 cell_size = glm::vec2(1.0f);
+		glm::vec2 item_half_extent = glm::vec2(0.0f);
+		Sint32 columns = 0;
+		Sint32 rows = 0;
+
+		// Cells are packed back to back, each keeps the room it was built with and only shrinks as entities leave
+		std::vector<Uint32> cell_start;
+		std::vector<Uint32> cell_count;
+		std::vector<Uint32> items;
+
+	public:
+		void Build(const std::vector<Entity>& entities, MeshType mesh_type, glm::vec2 new_cell_size, glm::vec2 new_item_half_extent);
+		void Remove(Uint32 entity_idx, glm::vec3 position);
+		void Query(glm::vec2 bounds_min, glm::vec2 bounds_max, std::vector<Uint32>& out_entities);
+
+	private:
+		Sint32 GetColumn(float x);
+		Sint32 GetRow(float z);
+	};
+
+	// ________________________________ Culling.cpp ________________________________
+	struct Frustum
+	{
+		glm::vec4 planes[6]; // inward facing normal | distance
+
+		static Frustum FromViewProj(const glm::mat4& view_proj);
+	};
+
+	// Writes 1 into visibility for every active entity whose world space bounding sphere touches the frustum
+	void CullEntities(const Frustum& frustum, std::vector<Entity>& entities, std::vector<Mesh>& meshes, std::vector<Uint8>& visibility, std::vector<float>& sphere_soa, RenderStats& stats);
+
+	// ________________________________ Instancing.cpp ________________________________
+	// Matches the std430 Instance struct in the *-instanced.vert shaders
+	struct InstanceData
+	{
+		glm::mat4 model;
+		Uint32 texture_layer;
+		Uint32 pad[3];
+	};
+
+	// A run of sorted render items sharing a pipeline, mesh and LOD, drawn with one instanced call
+	struct InstanceBatch
+	{
+		RenderPipelineID pipeline;
+		MeshType mesh_type;
+		Uint8 lod;
+		Uint32 first_instance;
+		Uint32 instance_count;
+	};
+
+	struct InstanceBuffer
+	{
+		SDL_GPUBuffer* storage_buff = nullptr;
+		SDL_GPUTransferBuffer* trans_buff = nullptr;
+		Uint32 capacity = 0; // in instances
+
+		std::vector<InstanceData> instances;
+		std::vector<InstanceBatch> batches;
+
+		void BuildBatches(RenderQueue& queue, std::vector<Entity>& entities);
+		void Reserve(SDL_GPUDevice* device, Uint32 instance_count);
+		Uint32 Upload(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass);
+		void Release(SDL_GPUDevice* device);
+	};
+
+	// ________________________________ RenderGraph.cpp ________________________________
+	enum RenderGraphAccess : Uint8
+	{
+		RG_ACCESS_NONE = 0x0,  // bound by the merged pass but never touched
+		RG_ACCESS_READ = 0x1,  // earlier contents needed, e.g. a depth test without writes
+		RG_ACCESS_WRITE = 0x2, // earlier contents kept and drawn over
+		RG_ACCESS_CLEAR = 0x3  // earlier contents discarded
+	};
+
+	typedef std::function<void(SDL_GPUCommandBuffer*, SDL_GPURenderPass*)> RenderGraphRecordFn;
+
+	struct RenderGraphResource
+	{
+		SDL_GPUTexture* texture;
+		bool keeps_contents; // what is in the texture before the frame matters
+		bool is_output;      // read after the frame, e.g. presented, so always stored
+		bool is_written;     // set while executing once a render pass has ended on it
+		SDL_FColor clear_color;
+		float clear_depth;
+	};
+
+	struct RenderGraphPass
+	{
+		const char* name;
+		Uint32 color_resource;
+		RenderGraphAccess color_access;
+		Sint32 depth_resource; // -1 without a depth attachment
+		RenderGraphAccess depth_access;
+		Sint32 blit_source;    // -1 for render passes, blits record outside of any render pass
+		std::vector<Uint32> dependencies;
+		RenderGraphRecordFn record;
+	};
+
+	// Rebuilt every frame, passes declare their attachments and dependencies
+	// Passes sharing attachments back to back are merged into one SDL render pass, load and store ops are inferred
+	struct RenderGraph
+	{
+		std::vector<RenderGraphResource> resources;
+		std::vector<RenderGraphPass> passes;
+		std::vector<Uint32> order;
+
+	public:
+		void Reset();
+		Uint32 ImportTexture(SDL_GPUTexture* texture, bool keeps_contents, bool is_output);
+		Uint32 AddPass(const char* name, Uint32 color_resource, RenderGraphAccess color_access, Sint32 depth_resource, RenderGraphAccess depth_access, RenderGraphRecordFn record);
+		Uint32 AddBlit(const char* name, Uint32 source_resource, Uint32 destination_resource, RenderGraphRecordFn record);
+		void AddDependency(Uint32 pass_idx, Uint32 depends_on_idx);
+		Uint32 Execute(SDL_GPUCommandBuffer* cmd_buff);
+
+	private:
+		void SortPasses();
+		bool CanMerge(const RenderGraphPass& group_pass, const RenderGraphPass& next_pass);
+		void ResolveOps(Uint32 resource_idx, RenderGraphAccess first_access, Uint32 group_end, SDL_GPULoadOp& out_load_op, SDL_GPUStoreOp& out_store_op);
+	};
+
+	// ________________________________ Benchmark.cpp ________________________________
+	// Slices of a benchmark frame, each one runs from the previous mark to its own
+	enum BenchStage : Uint8
+	{
+		BENCH_STAGE_UPDATE,
+		BENCH_STAGE_PREPARE,
+		BENCH_STAGE_UPLOAD,
+		BENCH_STAGE_RECORD,
+		BENCH_STAGE_SUBMIT,
+		BENCH_STAGE_GPU_WAIT,
+		BENCH_STAGE_MAX
+	};
+
+	struct BenchFrame
+	{
+		float frame_ms;
+		float stage_ms[BenchStage::BENCH_STAGE_MAX];
+		RenderStats render_stats;
+	};
+
+	// Headless run of a fixed number of frames along a fixed camera path, reported as json for comparing commits
+	struct Benchmark
+	{
+		bool is_enabled = false;
+		std::string scene_path;
+		std::string report_path = "bb3d_bench.json";
+		Uint32 frame_count = 600;
+		Uint32 warmup_count = 0;
+		float scene_load_ms = 0.0f;
+		SDL_GPUTexture* target = nullptr; // Stands in for the swapchain
+
+		std::vector<BenchFrame> frames;
+		BenchFrame current_frame = {};
+		Uint64 frame_start = 0;
+		Uint64 stage_start = 0;
+
+	public:
+		void BeginFrame();
+		void MarkStage(BenchStage stage);
+		void EndFrame(const RenderStats& render_stats);
+		void WriteReport(const char* driver_name, Resolution native_res, Resolution render_res);
+		void Release(SDL_GPUDevice* device);
+	};
+
+	// ________________________________ Lighting.cpp ________________________________
+	// Matches the std430 Light struct in light-cull.comp and model-phong-instanced.frag
+	struct LightData
+	{
+		glm::vec4 position_radius;
+		glm::vec4 color;
+	};
+
+	// Matches the cluster fields of the std140 UBOs in light-cull.comp and model-phong-instanced.frag
+	struct ClusterInfo
+	{
+		glm::vec2 screen_size;
+		float z_near;
+		float z_far;
+		Uint32 grid_size[4]; // x | y | depth slices | max lights per cluster
+	};
+
+	// Lights are uploaded once per frame and binned into view space clusters by a compute pass
+	struct LightBuffer
+	{
+		SDL_GPUBuffer* light_buff = nullptr;
+		SDL_GPUBuffer* cluster_count_buff = nullptr;
+		SDL_GPUBuffer* cluster_index_buff = nullptr;
+		SDL_GPUTransferBuffer* trans_buff = nullptr;
+		Uint32 capacity = 0; // in lights
+
+		std::vector<LightData> lights;
+		ClusterInfo cluster_info = {};
+
+		void Init(SDL_GPUDevice* device);
+		void Gather(std::vector<Entity>& entities);
+		void Reserve(SDL_GPUDevice* device, Uint32 light_count);
+		Uint32 Upload(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass);
+		void CullLights(SDL_GPUCommandBuffer* cmd_buff, SDL_GPUComputePipeline* cull_pipeline, const glm::mat4& view, const glm::mat4& proj, Resolution screen_res);
+		void Release(SDL_GPUDevice* device);
 	};
 
 	// ________________________________ UI.cpp ________________________________
+	// 20 bytes, position | UV | color as UBYTE4_NORM
+	struct UIVertex
+	{
+		float x, y;
+		float u, v;
+		Uint32 color;
+	};
+
 	struct UI_Element
 	{
 		SDL_GPUTexture* texture;
@@ -176,15 +807,51 @@ namespace BB3D
 		glm::vec2 pos;
 		glm::vec4 color;
 		bool is_visible = true;
+
+		// Retained glyph geometry in the UI buffer, only rebuilt while dirty
+		bool is_dirty = true;
+		unsigned int cache_offset = 0;		// bytes into the UI buffer
+		unsigned int cache_capacity = 0;	// glyphs
+		bool is_full_logged = false;		// the layer ran out of room for it, already reported once this scene
+
+		void SetText(const std::string& new_text);
+		void SetPos(glm::vec2 new_pos);
+		void SetColor(glm::vec4 new_color);
+		void SetVisible(bool new_is_visible);
+	};
+
+	struct UI_Upload
+	{
+		unsigned int staging_offset;
+		unsigned int buff_offset;
+		unsigned int size;
 	};
 
 	struct UI
 	{
-		unsigned int frame_offset = 0; // 1 vertex + 32 bytes
-		
-		void PushTextToUIBuff(SDL_GPUDevice* device, SDL_GPUBuffer* ui_buff, UI_TextField text_field, FontAtlas& atlas, Resolution screen_res);
-		void PushElementToUIBuff(SDL_GPUDevice* device, SDL_GPUBuffer* ui_buff, UI_Element elem);
+		// UI buffer layout
+		//  Retained text|Transient elements
+		// |------------>|------------------>|
+		unsigned int cache_end = 0;		// 1 vertex + 32 bytes
+		unsigned int frame_offset = 0;	// 1 vertex + 32 bytes
+		Uint32 cached_scene_id = ~0u;
+
+		// Persistent staging buffer, cycled by SDL on every map so the GPU can still read the previous frames
+		// Only mapped on frames where something actually changed
+		SDL_GPUTransferBuffer* staging_buff = nullptr;
+		Uint8* staging_ptr = nullptr;
+		unsigned int staging_offset = 0;
+		std::vector<UI_Upload> pending_uploads;
+
+		void Init(SDL_GPUDevice* device);
+		void BeginFrame(Uint32 scene_id, std::vector<UI_TextField>& text_fields);
+		void UpdateTextCache(SDL_GPUDevice* device, std::vector<UI_TextField>& text_fields, FontAtlas& atlas, Resolution screen_res);
+		void PushTextToUIBuff(SDL_GPUDevice* device, UI_TextField& text_field, FontAtlas& atlas, Resolution screen_res);
+		void PushElementToUIBuff(SDL_GPUDevice* device, const UI_Element& elem);
+		Uint32 EndFrame(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, SDL_GPUBuffer* ui_buff);
 		void FlushUIBuff(SDL_GPUDevice* device);
+		void Release(SDL_GPUDevice* device);
+		UIVertex* StageVertices(SDL_GPUDevice* device, unsigned int buff_offset, size_t vert_count);
 	};
 
 	SDL_GPUBuffer* CreateUILayerBuffer(SDL_GPUDevice* device);
@@ -208,8 +875,17 @@ namespace BB3D
 		std::vector<UI_Element>& GetSceneUIElems();
 		std::vector<UI_TextField>& GetSceneUITextFields();
 		Camera GetSceneCamera();
+		Uint32 GetSceneID();
+		Uint32 GetStateHash();
+		static void SeedRandom(Uint64 seed);
 
 	protected:
+		void ReadBakedScene(const char* filepath);
+		void ParseSceneJSON(const char* filepath);
+
+		static Uint32 s_NextSceneID;
+		static Random s_Random;
+		Uint32 m_SceneID;
 		Camera m_SceneCam;
 
 		std::vector<Entity> m_SceneEntities;
@@ -240,9 +916,10 @@ namespace BB3D
 	private:
 		bool m_IsButtonsDown[4];
 		std::function<void()> m_ToggleSkyboxCallback;
+		std::function<std::string()> m_CycleResolutionCallback;
 
 	public:
-		OptionsScene(const char* filepath, std::function<void(SceneType)> trans_to_callback, std::function<void()> toggle_skybox_callback);
+		OptionsScene(const char* filepath, std::function<void(SceneType)> trans_to_callback, std::function<void()> toggle_skybox_callback, std::function<std::string()> cycle_resolution_callback, const std::string& resolution_label);
 		~OptionsScene();
 
 		void Update(InputState& input_state, float delta_time) override;
@@ -252,6 +929,25 @@ namespace BB3D
 		bool IsInBox(float mouse_x, float mouse_y, glm::vec2 box_pos, float w, float h);
 	};
 
+	// Static scene with the camera orbiting its entities once over a fixed number of ticks
+	class BenchScene : public Scene
+	{
+	private:
+		glm::vec3 m_OrbitCenter;
+		float m_OrbitRadius;
+		Uint32 m_PathTicks;
+		Uint32 m_TickCount;
+
+	public:
+		BenchScene(const char* filepath, std::function<void(SceneType)> trans_to_callback, Uint32 path_ticks);
+		~BenchScene();
+
+		void Update(InputState& input_state, float delta_time) override;
+
+	private:
+		void PlaceCamera();
+	};
+
 	class GameScene : public Scene
 	{
 	private:
@@ -278,6 +974,9 @@ namespace BB3D
 
 		int m_PaddleHitCount;
 
+		CollisionGrid m_BlockGrid;
+		std::vector<Uint32> m_BlockCandidates;
+
 	public:
 		GameScene(const char* filepath, std::function<void(SceneType)> trans_to_callback);
 		~GameScene();
@@ -298,6 +997,7 @@ namespace BB3D
 	{
 	public:
 		// Lifetime
+		void ParseArgs(int argc, char** argv);
 		void Init();
 		void Run();
 		void Destroy();
@@ -310,10 +1010,12 @@ namespace BB3D
 		void Update();
 		void Input();
 		void Render();
+		void RunBenchmark();
 
 		// Utility
 		static void SceneTransToCallback(SceneType type);
 		static void OptionsToggleSkyboxCallback();
+		static std::string OptionsCycleResolutionCallback();
 		void RecordKeyState(SDL_Keycode keycode, bool is_keydown);
 		void RecordMouseBtnState(Uint8 mousebtn_idx, bool is_btndown);
 		void CopyPrevInput();
@@ -326,27 +1028,48 @@ namespace BB3D
 		bool m_IsIdle = false;
 		Timer m_Timer;
 		InputState m_InputState;
+		InputReplay m_InputReplay;
+		Benchmark m_Bench;
 		static std::stack<std::unique_ptr<Scene>> s_SceneStack;
 		UI ui_layer;
 
 		// Options
 		static TextureType s_SelectedTex;
+		Uint64 m_SkyboxBudget = 0;
+		Uint8 m_Anisotropy = 8;
+		float m_LodBias = 0.0f;
 		static Resolution s_Resolution;
+		static DynamicResolution s_DynamicRes;
 
 		// SDL Context
 		static SDL_Window* s_Window;
 		static SDL_GPUDevice* s_Device;
+		SDL_GPUTextureFormat m_ColorFormat; // Swapchain format, or the offscreen target's when benchmarking
 
 		//	Renderer State
 		SDL_GPUGraphicsPipeline* m_PipelineSkybox;
 		SDL_GPUGraphicsPipeline* m_PipelineModelsPhong;
 		SDL_GPUGraphicsPipeline* m_PipelineModelsNoPhong;
 		SDL_GPUGraphicsPipeline* m_PipelineUI;
+		SDL_GPUComputePipeline* m_PipelineLightCull;
 		SDL_GPUBuffer* m_UIBuff;
 		std::vector<Mesh> m_Meshes;
+		GeometryPool m_GeometryPool;
 		std::vector<SDL_GPUTexture*> m_Textures;
+		SkyboxCache m_Skyboxes;
+		ThreadPool m_ThreadPool;
+		RenderQueue m_RenderQueue;
+		std::vector<Uint8> m_Visibility;
+		std::vector<float> m_CullSpheres; // culling scratch, kept between frames so it only reallocates when the scene grows
+		InstanceBuffer m_InstanceBuff;
+		LightBuffer m_LightBuff;
+		RenderStats m_RenderStats;
+		RenderGraph m_RenderGraph;
 
 		//	Global texture sampler
-		SDL_GPUSampler* m_Sampler;
+		SamplerCache m_Samplers;
+		SDL_GPUSampler* m_MaterialSampler;
+		SDL_GPUSampler* m_SkyboxSampler;
+		SDL_GPUSampler* m_UISampler;
 	};
 }
\ No newline at end of file
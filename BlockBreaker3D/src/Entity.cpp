@@ -2,18 +2,24 @@
 
 namespace BB3D
 {
-	void Entity::UpdateTransform()
+	static glm::mat4 ComposeTransform(glm::vec3 position, glm::vec3 rotation, glm::vec3 scale)
 	{
-		transform = glm::mat4(1.0f);
+		glm::mat4 new_transform = glm::mat4(1.0f);
 		// Scale -> Rotate -> Transform
-		transform = glm::translate(transform, position);
+		new_transform = glm::translate(new_transform, position);
 
 		// Rotation for each axis
-		transform = glm::rotate(transform, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		transform = glm::rotate(transform, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		transform = glm::rotate(transform, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		new_transform = glm::rotate(new_transform, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+		new_transform = glm::rotate(new_transform, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+		new_transform = glm::rotate(new_transform, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+
+		new_transform = glm::scale(new_transform, scale);
+		return new_transform;
+	}
 
-		transform = glm::scale(transform, scale);
+	void Entity::UpdateTransform()
+	{
+		transform = ComposeTransform(position, rotation, scale);
 	}
 
 	glm::mat4 Entity::GetTransformMatrix()
@@ -21,12 +27,36 @@ namespace BB3D
 		return transform;
 	}
 
-	void Entity::Draw(SDL_GPURenderPass* render_pass, SDL_GPUBufferBinding vbo_bind, SDL_GPUBufferBinding ibo_bind, SDL_GPUTextureSamplerBinding tex_bind, int ind_count)
+	void Entity::StorePrevState()
+	{
+		prev_position = position;
+		prev_rotation = rotation;
+		prev_scale = scale;
+		has_prev_state = true;
+	}
+
+	void Entity::Interpolate(float alpha)
 	{
-		SDL_BindGPUVertexBuffers(render_pass, 0, &vbo_bind, 1);
-		SDL_BindGPUIndexBuffer(render_pass, &ibo_bind, SDL_GPU_INDEXELEMENTSIZE_16BIT);
-		SDL_BindGPUFragmentSamplers(render_pass, 0, &tex_bind, 1);
+		// Not ticked yet, nothing to blend from
+		if (!has_prev_state)
+		{
+			render_transform = ComposeTransform(position, rotation, scale);
+			return;
+		}
+
+		// Shortest way around so a wrap from 360 to 0 does not spin backwards for a frame
+		glm::vec3 rotation_delta = rotation - prev_rotation;
+		rotation_delta -= 360.0f * glm::round(rotation_delta / 360.0f);
 
-		SDL_DrawGPUIndexedPrimitives(render_pass, ind_count, 1, 0, 0, 0);
+		render_transform = ComposeTransform(
+			glm::mix(prev_position, position, alpha),
+			prev_rotation + rotation_delta * alpha,
+			glm::mix(prev_scale, scale, alpha)
+		);
+	}
+
+	glm::mat4 Entity::GetRenderTransform()
+	{
+		return render_transform;
 	}
 }
\ No newline at end of file
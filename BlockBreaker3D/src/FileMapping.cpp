@@ -0,0 +1,96 @@
+#include "Engine.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace BB3D
+{
+	bool MappedFile::Open(const char* filepath)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size = {};
+		if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping)
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!view)
+		{
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return false;
+		}
+
+		file_handle = file;
+		mapping_handle = mapping;
+		data = static_cast<const Uint8*>(view);
+		size = static_cast<size_t>(file_size.QuadPart);
+#else
+		int fd = open(filepath, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat file_stat = {};
+		if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* view = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping keeps its own reference to the file
+		close(fd);
+		if (view == MAP_FAILED)
+			return false;
+
+		// Read front to back exactly once on the way into the transfer buffer
+		madvise(view, static_cast<size_t>(file_stat.st_size), MADV_SEQUENTIAL);
+
+		data = static_cast<const Uint8*>(view);
+		size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+		if (!data)
+			return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(data);
+		CloseHandle(static_cast<HANDLE>(mapping_handle));
+		CloseHandle(static_cast<HANDLE>(file_handle));
+		mapping_handle = nullptr;
+		file_handle = nullptr;
+#else
+		munmap(const_cast<Uint8*>(data), size);
+#endif
+
+		data = nullptr;
+		size = 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "Engine.h"
+
+namespace BB3D
+{
+	void GeometryPool::Init(SDL_GPUDevice* device, Uint32 new_vertex_capacity, Uint32 new_index_capacity, SDL_GPUIndexElementSize new_index_size)
+	{
+		index_size = new_index_size;
+
+		SDL_GPUBufferCreateInfo vbo_info = {};
+		vbo_info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
+		vbo_info.size = new_vertex_capacity * sizeof(MeshVertex);
+		vbo = SDL_CreateGPUBuffer(device, &vbo_info);
+
+		SDL_GPUBufferCreateInfo ibo_info = {};
+		ibo_info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
+		ibo_info.size = new_index_capacity * GetIndexStride();
+		ibo = SDL_CreateGPUBuffer(device, &ibo_info);
+
+		if (!vbo || !ibo)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create geometry pool for %u vertices and %u indices: %s\n", new_vertex_capacity, new_index_capacity, SDL_GetError());
+			std::abort();
+		}
+
+		vertex_capacity = new_vertex_capacity;
+		index_capacity = new_index_capacity;
+		vertex_count = 0;
+		index_count = 0;
+	}
+
+	bool GeometryPool::Allocate(Uint32 vert_count, Uint32 ind_count, Uint32& out_base_vertex, Uint32& out_first_index)
+	{
+		if (vertex_count + vert_count > vertex_capacity || index_count + ind_count > index_capacity)
+			return false;
+
+		// Meshes live for the whole run, so a bump allocator is all the pool needs
+		out_base_vertex = vertex_count;
+		out_first_index = index_count;
+		vertex_count += vert_count;
+		index_count += ind_count;
+		return true;
+	}
+
+	Uint32 GeometryPool::GetIndexStride()
+	{
+		return index_size == SDL_GPU_INDEXELEMENTSIZE_32BIT ? sizeof(Uint32) : sizeof(Uint16);
+	}
+
+	void GeometryPool::Release(SDL_GPUDevice* device)
+	{
+		if (vbo)
+			SDL_ReleaseGPUBuffer(device, vbo);
+		if (ibo)
+			SDL_ReleaseGPUBuffer(device, ibo);
+
+		vbo = nullptr;
+		ibo = nullptr;
+		vertex_capacity = 0;
+		index_capacity = 0;
+		vertex_count = 0;
+		index_count = 0;
+	}
+}
\ No newline at end of file
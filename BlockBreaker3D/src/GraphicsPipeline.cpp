@@ -14,12 +14,21 @@ namespace BB3D
 		SDL_GPUGraphicsPipelineTargetInfo target_info_pipeline = {};
 		target_info_pipeline.num_color_targets = 1;
 		target_info_pipeline.color_target_descriptions = &color_target_dscr;
+		target_info_pipeline.has_depth_stencil_target = true;
+		target_info_pipeline.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM;
+
+		// The cube sits exactly on the far plane, so it only survives where the cleared depth was never written
+		SDL_GPUDepthStencilState depth_state = {};
+		depth_state.enable_depth_test = true;
+		depth_state.enable_depth_write = false;
+		depth_state.compare_op = SDL_GPU_COMPAREOP_LESS_OR_EQUAL;
 
 		SDL_GPUGraphicsPipelineCreateInfo create_info_pipeline = {};
 		create_info_pipeline.vertex_shader = vert_shader;
 		create_info_pipeline.fragment_shader = frag_shader;
 		create_info_pipeline.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
 		create_info_pipeline.target_info = target_info_pipeline;
+		create_info_pipeline.depth_stencil_state = depth_state;
 
 		new_pipeline = SDL_CreateGPUGraphicsPipeline(device, &create_info_pipeline);
 		if (!new_pipeline)
@@ -51,16 +60,16 @@ namespace BB3D
 		attribs[0].offset = 0;
 		attribs[1].location = 1;
 		attribs[1].buffer_slot = 0;
-		attribs[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
-		attribs[1].offset = sizeof(float) * 3;
+		attribs[1].format = SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM;
+		attribs[1].offset = offsetof(MeshVertex, normal_oct);
 		attribs[2].location = 2;
 		attribs[2].buffer_slot = 0;
-		attribs[2].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
-		attribs[2].offset = sizeof(float) * 6;
+		attribs[2].format = SDL_GPU_VERTEXELEMENTFORMAT_HALF2;
+		attribs[2].offset = offsetof(MeshVertex, uv_half);
 
 		SDL_GPUVertexBufferDescription vbo_descr = {};
 		vbo_descr.slot = 0;
-		vbo_descr.pitch = sizeof(Vertex);
+		vbo_descr.pitch = sizeof(MeshVertex);
 		vbo_descr.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
 		vbo_descr.instance_step_rate = 0;
 
@@ -103,7 +112,9 @@ namespace BB3D
 		SDL_GPUGraphicsPipelineTargetInfo target_info_pipeline = {};
 		target_info_pipeline.num_color_targets = 1;
 		target_info_pipeline.color_target_descriptions = &color_target_dscr;
-		target_info_pipeline.has_depth_stencil_target = false;
+		// Shares the render pass with the 3D stages, so the depth buffer is bound but never tested or written
+		target_info_pipeline.has_depth_stencil_target = true;
+		target_info_pipeline.depth_stencil_format = SDL_GPU_TEXTUREFORMAT_D24_UNORM;
 
 		SDL_GPUVertexAttribute attribs[3] = {};
 		attribs[0].location = 0;
@@ -113,15 +124,15 @@ namespace BB3D
 		attribs[1].location = 1;
 		attribs[1].buffer_slot = 0;
 		attribs[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
-		attribs[1].offset = sizeof(float) * 2;
+		attribs[1].offset = offsetof(UIVertex, u);
 		attribs[2].location = 2;
 		attribs[2].buffer_slot = 0;
-		attribs[2].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4;
-		attribs[2].offset = sizeof(float) * 4;
+		attribs[2].format = SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM;
+		attribs[2].offset = offsetof(UIVertex, color);
 
 		SDL_GPUVertexBufferDescription vbo_descr = {};
 		vbo_descr.slot = 0;
-		vbo_descr.pitch = sizeof(Vertex);
+		vbo_descr.pitch = sizeof(UIVertex);
 		vbo_descr.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
 		vbo_descr.instance_step_rate = 0;
 
@@ -0,0 +1,109 @@
+#include "Engine.h"
+
+#define INSTANCE_CAPACITY_MIN 64
+
+namespace BB3D
+{
+	void InstanceBuffer::BuildBatches(RenderQueue& queue, std::vector<Entity>& entities)
+	{
+		instances.resize(queue.items.size());
+		batches.clear();
+
+		// The queue is sorted, so every run of equal pipeline, mesh and LOD bits becomes one batch
+		Uint64 batch_state = ~0ull;
+		for (Uint32 i = 0; i < queue.items.size(); i++)
+		{
+			RenderItem& item = queue.items[i];
+			Entity& current_entity = entities[item.entity_idx];
+
+			if (RenderQueue::GetStateBits(item.sort_key) != batch_state)
+			{
+				batch_state = RenderQueue::GetStateBits(item.sort_key);
+				batches.push_back({ RenderQueue::GetPipeline(item.sort_key), RenderQueue::GetMesh(item.sort_key), RenderQueue::GetLod(item.sort_key), i, 0 });
+			}
+
+			InstanceData& new_instance = instances[i];
+			new_instance.model = current_entity.GetRenderTransform();
+			new_instance.texture_layer = current_entity.texture_type - TextureType::GEM10; // material array starts at the first material texture
+			batches.back().instance_count++;
+		}
+	}
+
+	void InstanceBuffer::Reserve(SDL_GPUDevice* device, Uint32 instance_count)
+	{
+		if (instance_count <= capacity)
+			return;
+
+		Uint32 new_capacity = capacity ? capacity : INSTANCE_CAPACITY_MIN;
+		while (new_capacity < instance_count)
+			new_capacity *= 2;
+
+		Release(device);
+
+		SDL_GPUBufferCreateInfo storage_buff_info = {};
+		storage_buff_info.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+		storage_buff_info.size = sizeof(InstanceData) * new_capacity;
+		storage_buff = SDL_CreateGPUBuffer(device, &storage_buff_info);
+		if (!storage_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create instance storage buffer: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		SDL_GPUTransferBufferCreateInfo instance_transfer_create_info = {};
+		instance_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+		instance_transfer_create_info.size = sizeof(InstanceData) * new_capacity;
+		trans_buff = SDL_CreateGPUTransferBuffer(device, &instance_transfer_create_info);
+		if (!trans_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create transfer buffer for instance data: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		capacity = new_capacity;
+	}
+
+	Uint32 InstanceBuffer::Upload(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass)
+	{
+		if (instances.empty())
+			return 0;
+
+		Reserve(device, instances.size());
+
+		Uint32 upload_size = sizeof(InstanceData) * instances.size();
+
+		// Cycle so last frame's instance data can still be read by the GPU while this frame is written
+		void* instance_trans_ptr = SDL_MapGPUTransferBuffer(device, trans_buff, true);
+		if (!instance_trans_ptr)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map transfer buffer for instance data: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		std::memcpy(instance_trans_ptr, instances.data(), upload_size);
+		SDL_UnmapGPUTransferBuffer(device, trans_buff);
+
+		SDL_GPUTransferBufferLocation instance_trans_location = {};
+		instance_trans_location.transfer_buffer = trans_buff;
+		instance_trans_location.offset = 0;
+		SDL_GPUBufferRegion instance_region = {};
+		instance_region.buffer = storage_buff;
+		instance_region.offset = 0;
+		instance_region.size = upload_size;
+
+		SDL_UploadToGPUBuffer(copy_pass, &instance_trans_location, &instance_region, true);
+		return upload_size;
+	}
+
+	void InstanceBuffer::Release(SDL_GPUDevice* device)
+	{
+		if (storage_buff)
+			SDL_ReleaseGPUBuffer(device, storage_buff);
+		if (trans_buff)
+			SDL_ReleaseGPUTransferBuffer(device, trans_buff);
+
+		storage_buff = nullptr;
+		trans_buff = nullptr;
+		capacity = 0;
+	}
+}
\ No newline at end of file
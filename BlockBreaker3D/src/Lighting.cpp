@@ -0,0 +1,190 @@
+#include "Engine.h"
+
+#define LIGHT_CAPACITY_MIN 64
+#define LIGHT_RADIUS_DEFAULT 20.0f
+
+// 16x9 screen tiles and 24 exponential depth slices
+#define CLUSTER_GRID_X 16
+#define CLUSTER_GRID_Y 9
+#define CLUSTER_GRID_Z 24
+#define CLUSTER_COUNT (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+#define CLUSTER_MAX_LIGHTS 128
+#define CLUSTER_Z_NEAR 0.1f
+#define CLUSTER_Z_FAR 100.0f
+#define LIGHT_CULL_THREADS 64
+
+namespace BB3D
+{
+	void LightBuffer::Init(SDL_GPUDevice* device)
+	{
+		SDL_GPUBufferCreateInfo cluster_count_info = {};
+		cluster_count_info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+		cluster_count_info.size = sizeof(Uint32) * CLUSTER_COUNT;
+		cluster_count_buff = SDL_CreateGPUBuffer(device, &cluster_count_info);
+		if (!cluster_count_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create cluster count buffer: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		// Every cluster owns a fixed run of CLUSTER_MAX_LIGHTS indices, so the cull shader needs no atomics
+		SDL_GPUBufferCreateInfo cluster_index_info = {};
+		cluster_index_info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+		cluster_index_info.size = sizeof(Uint32) * CLUSTER_COUNT * CLUSTER_MAX_LIGHTS;
+		cluster_index_buff = SDL_CreateGPUBuffer(device, &cluster_index_info);
+		if (!cluster_index_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create cluster index buffer: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		cluster_info.z_near = CLUSTER_Z_NEAR;
+		cluster_info.z_far = CLUSTER_Z_FAR;
+		cluster_info.grid_size[0] = CLUSTER_GRID_X;
+		cluster_info.grid_size[1] = CLUSTER_GRID_Y;
+		cluster_info.grid_size[2] = CLUSTER_GRID_Z;
+		cluster_info.grid_size[3] = CLUSTER_MAX_LIGHTS;
+
+		// The light buffer is always bound, even on frames without any lights
+		Reserve(device, LIGHT_CAPACITY_MIN);
+	}
+
+	void LightBuffer::Gather(std::vector<Entity>& entities)
+	{
+		lights.clear();
+
+		// Unshaded entities are the light sources
+		// Gathered before frustum culling since an off screen light can still reach visible geometry
+		for (Entity& current_entity : entities)
+		{
+			if (!current_entity.is_active || current_entity.is_shaded)
+				continue;
+
+			glm::vec3 light_pos = glm::vec3(current_entity.GetRenderTransform()[3]);
+			lights.push_back({ glm::vec4(light_pos, LIGHT_RADIUS_DEFAULT), glm::vec4(1.0f) });
+		}
+	}
+
+	void LightBuffer::Reserve(SDL_GPUDevice* device, Uint32 light_count)
+	{
+		if (light_count <= capacity)
+			return;
+
+		Uint32 new_capacity = capacity ? capacity : LIGHT_CAPACITY_MIN;
+		while (new_capacity < light_count)
+			new_capacity *= 2;
+
+		if (light_buff)
+			SDL_ReleaseGPUBuffer(device, light_buff);
+		if (trans_buff)
+			SDL_ReleaseGPUTransferBuffer(device, trans_buff);
+
+		SDL_GPUBufferCreateInfo light_buff_info = {};
+		light_buff_info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+		light_buff_info.size = sizeof(LightData) * new_capacity;
+		light_buff = SDL_CreateGPUBuffer(device, &light_buff_info);
+		if (!light_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create light storage buffer: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		SDL_GPUTransferBufferCreateInfo light_transfer_create_info = {};
+		light_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+		light_transfer_create_info.size = sizeof(LightData) * new_capacity;
+		trans_buff = SDL_CreateGPUTransferBuffer(device, &light_transfer_create_info);
+		if (!trans_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create transfer buffer for light data: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		capacity = new_capacity;
+	}
+
+	Uint32 LightBuffer::Upload(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass)
+	{
+		if (lights.empty())
+			return 0;
+
+		Reserve(device, lights.size());
+
+		Uint32 upload_size = sizeof(LightData) * lights.size();
+
+		void* light_trans_ptr = SDL_MapGPUTransferBuffer(device, trans_buff, true);
+		if (!light_trans_ptr)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map transfer buffer for light data: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		std::memcpy(light_trans_ptr, lights.data(), upload_size);
+		SDL_UnmapGPUTransferBuffer(device, trans_buff);
+
+		SDL_GPUTransferBufferLocation light_trans_location = {};
+		light_trans_location.transfer_buffer = trans_buff;
+		light_trans_location.offset = 0;
+		SDL_GPUBufferRegion light_region = {};
+		light_region.buffer = light_buff;
+		light_region.offset = 0;
+		light_region.size = upload_size;
+
+		SDL_UploadToGPUBuffer(copy_pass, &light_trans_location, &light_region, true);
+		return upload_size;
+	}
+
+	void LightBuffer::CullLights(SDL_GPUCommandBuffer* cmd_buff, SDL_GPUComputePipeline* cull_pipeline, const glm::mat4& view, const glm::mat4& proj, Resolution screen_res)
+	{
+		cluster_info.screen_size = glm::vec2(static_cast<float>(screen_res.w), static_cast<float>(screen_res.h));
+
+		// view | projection scale | cluster info | light count | 3xpad
+		struct
+		{
+			glm::mat4 view;
+			glm::vec2 proj_scale;
+			float z_near;
+			float z_far;
+			Uint32 grid_size[4];
+			Uint32 light_count;
+			Uint32 pad[3];
+		} c_ubo = {};
+		c_ubo.view = view;
+		c_ubo.proj_scale = glm::vec2(proj[0][0], proj[1][1]);
+		c_ubo.z_near = cluster_info.z_near;
+		c_ubo.z_far = cluster_info.z_far;
+		std::memcpy(c_ubo.grid_size, cluster_info.grid_size, sizeof(c_ubo.grid_size));
+		c_ubo.light_count = lights.size();
+
+		// Cycle both outputs so last frame's fragment shading can keep reading its clusters
+		SDL_GPUStorageBufferReadWriteBinding cluster_binds[2] = {};
+		cluster_binds[0].buffer = cluster_count_buff;
+		cluster_binds[0].cycle = true;
+		cluster_binds[1].buffer = cluster_index_buff;
+		cluster_binds[1].cycle = true;
+
+		SDL_GPUComputePass* cull_pass = SDL_BeginGPUComputePass(cmd_buff, nullptr, 0, cluster_binds, 2);
+		SDL_BindGPUComputePipeline(cull_pass, cull_pipeline);
+		SDL_BindGPUComputeStorageBuffers(cull_pass, 0, &light_buff, 1);
+		SDL_PushGPUComputeUniformData(cmd_buff, 0, &c_ubo, sizeof(c_ubo));
+		SDL_DispatchGPUCompute(cull_pass, (CLUSTER_COUNT + LIGHT_CULL_THREADS - 1) / LIGHT_CULL_THREADS, 1, 1);
+		SDL_EndGPUComputePass(cull_pass);
+	}
+
+	void LightBuffer::Release(SDL_GPUDevice* device)
+	{
+		if (light_buff)
+			SDL_ReleaseGPUBuffer(device, light_buff);
+		if (trans_buff)
+			SDL_ReleaseGPUTransferBuffer(device, trans_buff);
+		if (cluster_count_buff)
+			SDL_ReleaseGPUBuffer(device, cluster_count_buff);
+		if (cluster_index_buff)
+			SDL_ReleaseGPUBuffer(device, cluster_index_buff);
+
+		light_buff = nullptr;
+		trans_buff = nullptr;
+		cluster_count_buff = nullptr;
+		cluster_index_buff = nullptr;
+		capacity = 0;
+	}
+}
\ No newline at end of file
@@ -1,117 +1,143 @@
 #include "Engine.h"
-#include <iostream>
 #include <vector>
 
-#include <assimp/Importer.hpp>
-#include <assimp/scene.h>
-#include <assimp/postprocess.h>
-
 namespace BB3D
 {
-	Mesh LoadMeshFromFile(SDL_GPUDevice* device, const char* filepath)
+	void MeshAsset::Read()
 	{
-		Assimp::Importer importer;
-		const aiScene* scene = importer.ReadFile(filepath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals);
-		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE)
+		BB3D_PROFILE_ZONE("MeshAsset::Read");
+
+		// OBJ files are baked offline by MeshBaker, the runtime never touches Assimp
+		if (!file.Open(filepath.c_str()))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map baked mesh %s\n", filepath.c_str());
+			std::abort();
+		}
+
+		if (file.size < sizeof(BakedMeshHeader))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked mesh %s is truncated\n", filepath.c_str());
+			std::abort();
+		}
+
+		std::memcpy(&header, file.data, sizeof(BakedMeshHeader));
+
+		if (header.magic != BAKED_MESH_MAGIC || header.version != BAKED_MESH_VERSION)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to load model from %s: ASSIMP: %s\n", filepath, importer.GetErrorString());
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked mesh %s has an unknown format or version %u, rebuild the MeshBaker target\n", filepath.c_str(), header.version);
 			std::abort();
 		}
 
-		aiMesh* loaded_mesh = scene->mMeshes[0];
+		if (header.vertex_stride != sizeof(MeshVertex) || (header.index_size != sizeof(Uint16) && header.index_size != sizeof(Uint32)))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked mesh %s has a %u byte vertex and %u byte index, expected %u and 2 or 4\n",
+				filepath.c_str(), header.vertex_stride, header.index_size, static_cast<Uint32>(sizeof(MeshVertex)));
+			std::abort();
+		}
 
-		std::vector<Vertex> loaded_vertices = {};
-		std::vector<Uint16> loaded_indices = {};
+		Uint64 vbo_end = static_cast<Uint64>(header.vertex_offset) + static_cast<Uint64>(header.vertex_count) * header.vertex_stride;
+		Uint64 ibo_end = static_cast<Uint64>(header.index_offset) + static_cast<Uint64>(header.index_count) * header.index_size;
+		if (vbo_end > file.size || ibo_end > file.size)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked mesh %s is truncated\n", filepath.c_str());
+			std::abort();
+		}
 
-		for (int i = 0; i < loaded_mesh->mNumVertices; i++)
+		if (!header.lod_count || header.lod_count > BAKED_MESH_MAX_LODS)
 		{
-			Vertex new_vert = {};
-
-			new_vert[0] = loaded_mesh->mVertices[i].x;
-			new_vert[1] = loaded_mesh->mVertices[i].y;
-			new_vert[2] = loaded_mesh->mVertices[i].z;
-			new_vert[3] = loaded_mesh->mNormals[i].x;
-			new_vert[4] = loaded_mesh->mNormals[i].y;
-			new_vert[5] = loaded_mesh->mNormals[i].z;
-			new_vert[6] = loaded_mesh->mTextureCoords[0][i].x;
-			new_vert[7] = loaded_mesh->mTextureCoords[0][i].y;
-
-			loaded_vertices.push_back(new_vert);
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked mesh %s has %u LODs, expected 1 to %u\n", filepath.c_str(), header.lod_count, BAKED_MESH_MAX_LODS);
+			std::abort();
 		}
 
-		for (int i = 0; i < loaded_mesh->mNumFaces; i++)
+		mesh.vert_count = header.vertex_count;
+		mesh.lod_count = header.lod_count;
+		for (Uint32 i = 0; i < header.lod_count; i++)
 		{
-			aiFace face = loaded_mesh->mFaces[i];
-			for (int j = 0; j < face.mNumIndices; j++)
+			const BakedMeshLod& baked_lod = header.lods[i];
+			if (static_cast<Uint64>(baked_lod.first_index) + baked_lod.index_count > header.index_count)
 			{
-				loaded_indices.push_back(static_cast<Uint16>(face.mIndices[j]));
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked mesh %s LOD %u runs past the index buffer\n", filepath.c_str(), i);
+				std::abort();
 			}
-		}
 
-		Mesh new_mesh = CreateMesh(device, loaded_vertices, loaded_indices);
-		new_mesh.vert_count = loaded_vertices.size();
-		new_mesh.ind_count = loaded_indices.size();
-		return new_mesh;
+			mesh.lods[i] = { baked_lod.first_index, baked_lod.index_count, baked_lod.error };
+		}
+		mesh.aabb_min = glm::vec3(header.aabb_min[0], header.aabb_min[1], header.aabb_min[2]);
+		mesh.aabb_max = glm::vec3(header.aabb_max[0], header.aabb_max[1], header.aabb_max[2]);
+		mesh.sphere_center = glm::vec3(header.sphere_center[0], header.sphere_center[1], header.sphere_center[2]);
+		mesh.sphere_radius = header.sphere_radius;
 	}
 
-	Mesh CreateMesh(SDL_GPUDevice* device, std::vector<Vertex> vertices, std::vector<Uint16> indices)
+	void MeshAsset::Allocate(GeometryPool& pool)
 	{
-		Mesh new_mesh = {};
-
-		Uint32 vbo_size = sizeof(Vertex) * vertices.size();
-		Uint32 ibo_size = sizeof(Uint16) * indices.size();
+		Uint32 base_vertex = 0;
+		if (!pool.Allocate(header.vertex_count, header.index_count, base_vertex, mesh.first_index))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Geometry pool is out of space for %s\n", filepath.c_str());
+			std::abort();
+		}
 
-		SDL_GPUBufferCreateInfo vbo_info = {};
-		vbo_info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-		vbo_info.size = vbo_size;
-		new_mesh.vbo = SDL_CreateGPUBuffer(device, &vbo_info);
+		mesh.base_vertex = static_cast<Sint32>(base_vertex);
+		geometry_pool = &pool;
+	}
 
-		SDL_GPUBufferCreateInfo ibo_info = {};
-		ibo_info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-		ibo_info.size = ibo_size;
-		new_mesh.ibo = SDL_CreateGPUBuffer(device, &ibo_info);
+	Uint32 MeshAsset::GetStagingSize()
+	{
+		return header.vertex_count * header.vertex_stride + header.index_count * geometry_pool->GetIndexStride();
+	}
 
-		SDL_GPUTransferBufferCreateInfo mesh_transfer_create_info = {};
-		mesh_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-		mesh_transfer_create_info.size = vbo_size + ibo_size;
-		SDL_GPUTransferBuffer* mesh_trans_buff = SDL_CreateGPUTransferBuffer(device, &mesh_transfer_create_info);
+	void MeshAsset::Stage(Uint8* staging_ptr)
+	{
+		BB3D_PROFILE_ZONE("MeshAsset::Stage");
 
-		void* mesh_trans_ptr = SDL_MapGPUTransferBuffer(device, mesh_trans_buff, false);
+		Uint32 vbo_size = header.vertex_count * header.vertex_stride;
+		Uint32 index_stride = geometry_pool->GetIndexStride();
 
+		// Straight from the mapped pages into the transfer buffer
 		//  Vertices|Indices
 		// |------->|
-		std::memcpy(mesh_trans_ptr, vertices.data(), vbo_size);
-		std::memcpy(reinterpret_cast<Vertex*>(mesh_trans_ptr) + vertices.size(), indices.data(), ibo_size);
+		std::memcpy(staging_ptr + staging_offset, file.data + header.vertex_offset, vbo_size);
 
-		SDL_UnmapGPUTransferBuffer(device, mesh_trans_buff);
+		// 16 bit meshes are widened when another mesh forced the pool to 32 bit
+		if (index_stride == header.index_size)
+		{
+			std::memcpy(staging_ptr + staging_offset + vbo_size, file.data + header.index_offset, header.index_count * index_stride);
+		}
+		else
+		{
+			Uint16 narrow_index;
+			Uint32 wide_index;
+			for (Uint32 i = 0; i < header.index_count; i++)
+			{
+				std::memcpy(&narrow_index, file.data + header.index_offset + i * sizeof(Uint16), sizeof(Uint16));
+				wide_index = narrow_index;
+				std::memcpy(staging_ptr + staging_offset + vbo_size + i * sizeof(Uint32), &wide_index, sizeof(Uint32));
+			}
+		}
+	}
 
-		SDL_GPUCommandBuffer* mesh_copy_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
-		SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(mesh_copy_cmd_buff);
+	void MeshAsset::Upload(SDL_GPUCopyPass* copy_pass, SDL_GPUTransferBuffer* trans_buff)
+	{
+		Uint32 vbo_size = header.vertex_count * header.vertex_stride;
+		Uint32 index_stride = geometry_pool->GetIndexStride();
 
 		SDL_GPUTransferBufferLocation mesh_trans_location = {};
-		mesh_trans_location.transfer_buffer = mesh_trans_buff;
-		mesh_trans_location.offset = 0;
+		mesh_trans_location.transfer_buffer = trans_buff;
+		mesh_trans_location.offset = staging_offset;
 		SDL_GPUBufferRegion vbo_region = {};
-		vbo_region.buffer = new_mesh.vbo;
-		vbo_region.offset = 0;
+		vbo_region.buffer = geometry_pool->vbo;
+		vbo_region.offset = static_cast<Uint32>(mesh.base_vertex) * header.vertex_stride;
 		vbo_region.size = vbo_size;
 		SDL_GPUBufferRegion ibo_region = {};
-		ibo_region.buffer = new_mesh.ibo;
-		ibo_region.offset = 0;
-		ibo_region.size = ibo_size;
+		ibo_region.buffer = geometry_pool->ibo;
+		ibo_region.offset = mesh.first_index * index_stride;
+		ibo_region.size = header.index_count * index_stride;
 
 		SDL_UploadToGPUBuffer(copy_pass, &mesh_trans_location, &vbo_region, false);
-		mesh_trans_location.offset = vbo_size;
+		mesh_trans_location.offset = staging_offset + vbo_size;
 		SDL_UploadToGPUBuffer(copy_pass, &mesh_trans_location, &ibo_region, false);
 
-		SDL_EndGPUCopyPass(copy_pass);
-		SDL_ReleaseGPUTransferBuffer(device, mesh_trans_buff);
-		if (!SDL_SubmitGPUCommandBuffer(mesh_copy_cmd_buff))
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit copy command buffer to GPU: %s\n", SDL_GetError());
-			std::abort();
-		}
-
-		return new_mesh;
+		// Already staged, the mapping is no longer needed
+		file.Close();
 	}
 }
\ No newline at end of file
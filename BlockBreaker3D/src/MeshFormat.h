@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+// Baked mesh layout shared by the engine and the MeshBaker tool
+// Header | Vertices | Indices, both blocks are stored exactly as they get uploaded to the GPU
+#define BAKED_MESH_MAGIC 0x4D334242 // "BB3M"
+#define BAKED_MESH_VERSION 4
+#define BAKED_MESH_EXTENSION ".bb3dmesh"
+#define BAKED_MESH_MAX_LODS 4
+
+namespace BB3D
+{
+	// 20 bytes, position | octahedral normal as SHORT2_NORM | UV as HALF2
+	struct MeshVertex
+	{
+		float position[3];
+		int16_t normal_oct[2];
+		uint16_t uv_half[2];
+	};
+
+	static_assert(sizeof(MeshVertex) == 20, "MeshVertex must match the model pipeline vertex layout");
+
+	// A run of the shared index buffer, every LOD draws from the same vertices
+	struct BakedMeshLod
+	{
+		uint32_t first_index;
+		uint32_t index_count;
+		float error; // largest RMS quadric plane distance in object units, an estimate not a bound, 0 for LOD 0
+	};
+
+	struct BakedMeshHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t vertex_count;
+		uint32_t index_count;
+		uint32_t vertex_stride;
+		uint32_t index_size; // 2 or 4, 32 bit only once a mesh outgrows 16 bit indices
+
+		// Byte offsets from the start of the file
+		uint32_t vertex_offset;
+		uint32_t index_offset;
+
+		// Object space bounds so the runtime never has to walk the vertices
+		float aabb_min[3];
+		float aabb_max[3];
+		float sphere_center[3];
+		float sphere_radius;
+
+		// Finest first, only the first lod_count entries are valid
+		uint32_t lod_count;
+		BakedMeshLod lods[BAKED_MESH_MAX_LODS];
+	};
+
+	static_assert(sizeof(BakedMeshHeader) == 124, "BakedMeshHeader must stay tightly packed");
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include "Engine.h"
+
+#ifdef BB3D_PROFILE
+#include <mutex>
+#include <atomic>
+#include <fstream>
+
+#define PROFILE_RING_SIZE 65536 // zones per thread, the oldest get overwritten
+
+namespace BB3D
+{
+	// Only the owning thread writes into a ring, so recording a zone never takes a lock
+	// write_count is published after the zone, a reader that acquires it sees every zone below it
+	struct ProfileRing
+	{
+		ProfileZone zones[PROFILE_RING_SIZE];
+		std::atomic<Uint64> write_count = 0;
+		SDL_ThreadID thread_id = 0;
+	};
+
+	static std::mutex s_RingsLock;
+	static std::vector<std::unique_ptr<ProfileRing>> s_Rings;
+
+	static ProfileRing& GetThreadRing()
+	{
+		thread_local ProfileRing* thread_ring = nullptr;
+		if (!thread_ring)
+		{
+			std::lock_guard<std::mutex> rings_lock(s_RingsLock);
+			s_Rings.push_back(std::make_unique<ProfileRing>());
+			thread_ring = s_Rings.back().get();
+			thread_ring->thread_id = SDL_GetCurrentThreadID();
+		}
+
+		return *thread_ring;
+	}
+
+	ProfileScope::ProfileScope(const char* zone_name)
+	{
+		name = zone_name;
+		start_ns = SDL_GetTicksNS();
+	}
+
+	ProfileScope::~ProfileScope()
+	{
+		ProfilerRecordZone(name, start_ns, SDL_GetTicksNS());
+	}
+
+	void ProfilerRecordZone(const char* name, Uint64 start_ns, Uint64 end_ns)
+	{
+		ProfileRing& ring = GetThreadRing();
+		Uint64 write_count = ring.write_count.load(std::memory_order_relaxed);
+		ring.zones[write_count % PROFILE_RING_SIZE] = { name, start_ns, end_ns };
+		ring.write_count.store(write_count + 1, std::memory_order_release);
+	}
+
+	void ProfilerDumpChromeTrace(const char* filepath)
+	{
+		std::lock_guard<std::mutex> rings_lock(s_RingsLock);
+
+		std::ofstream trace_file(filepath);
+		if (!trace_file)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to open profiler trace file at: %s\n", filepath);
+			return;
+		}
+
+		// Complete ("X") events, timestamps and durations in microseconds
+		trace_file << "{\"traceEvents\":[\n";
+		bool is_first = true;
+		char event_buff[256];
+		std::vector<ProfileZone> zone_snapshot;
+		for (std::unique_ptr<ProfileRing>& ring : s_Rings)
+		{
+			// Workers can keep recording while this runs, so copy first and then drop whatever got lapped during the copy
+			Uint64 write_count = ring->write_count.load(std::memory_order_acquire);
+			Uint64 zone_count = write_count < PROFILE_RING_SIZE ? write_count : PROFILE_RING_SIZE;
+			zone_snapshot.resize(zone_count);
+			for (Uint64 i = 0; i < zone_count; i++)
+			{
+				zone_snapshot[i] = ring->zones[(write_count - zone_count + i) % PROFILE_RING_SIZE];
+			}
+
+			// A slot is only safe while the writer has not reached it again, including a write still in flight
+			Uint64 reach_count = ring->write_count.load(std::memory_order_acquire) - write_count + 1;
+			Uint64 free_slots = PROFILE_RING_SIZE - zone_count;
+			Uint64 first_valid = reach_count > free_slots ? SDL_min(reach_count - free_slots, zone_count) : 0;
+			for (Uint64 i = first_valid; i < zone_count; i++)
+			{
+				ProfileZone& zone = zone_snapshot[i];
+				SDL_snprintf(
+					event_buff,
+					sizeof(event_buff),
+					"%s{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":%llu,\"ts\":%.3f,\"dur\":%.3f}",
+					is_first ? "" : ",\n",
+					zone.name,
+					static_cast<unsigned long long>(ring->thread_id),
+					zone.start_ns / 1000.0,
+					(zone.end_ns - zone.start_ns) / 1000.0
+				);
+				trace_file << event_buff;
+				is_first = false;
+			}
+		}
+		trace_file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		SDL_Log("OK: Wrote profiler trace to %s\n", filepath);
+	}
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#include "Engine.h"
+
+namespace BB3D
+{
+	// PCG32 (O'Neill), same seed gives the same sequence on every platform
+	void Random::Seed(Uint64 seed)
+	{
+		state = 0;
+		increment = (seed << 1) | 1;
+		Next();
+		state += seed;
+		Next();
+	}
+
+	Uint32 Random::Next()
+	{
+		Uint64 old_state = state;
+		state = old_state * 6364136223846793005ULL + increment;
+
+		Uint32 xorshifted = static_cast<Uint32>(((old_state >> 18) ^ old_state) >> 27);
+		Uint32 rot = static_cast<Uint32>(old_state >> 59);
+		return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+	}
+
+	float Random::NextFloat()
+	{
+		// Top 24 bits fill the float mantissa exactly
+		return static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "Engine.h"
+#include <algorithm>
+
+namespace BB3D
+{
+	void RenderGraph::Reset()
+	{
+		resources.clear();
+		passes.clear();
+	}
+
+	Uint32 RenderGraph::ImportTexture(SDL_GPUTexture* texture, bool keeps_contents, bool is_output)
+	{
+		RenderGraphResource new_resource = {};
+		new_resource.texture = texture;
+		new_resource.keeps_contents = keeps_contents;
+		new_resource.is_output = is_output;
+		new_resource.clear_color = { 0.0f, 0.0f, 0.0f, 1.0f };
+		new_resource.clear_depth = 1.0f;
+		resources.push_back(new_resource);
+		return resources.size() - 1;
+	}
+
+	Uint32 RenderGraph::AddPass(const char* name, Uint32 color_resource, RenderGraphAccess color_access, Sint32 depth_resource, RenderGraphAccess depth_access, RenderGraphRecordFn record)
+	{
+		RenderGraphPass new_pass = {};
+		new_pass.name = name;
+		new_pass.color_resource = color_resource;
+		new_pass.color_access = color_access;
+		new_pass.depth_resource = depth_resource;
+		new_pass.depth_access = depth_resource >= 0 ? depth_access : RG_ACCESS_NONE;
+		new_pass.blit_source = -1;
+		new_pass.record = std::move(record);
+		passes.push_back(std::move(new_pass));
+		return passes.size() - 1;
+	}
+
+	// The destination is overwritten as a whole, so nothing before the blit is ever loaded
+	Uint32 RenderGraph::AddBlit(const char* name, Uint32 source_resource, Uint32 destination_resource, RenderGraphRecordFn record)
+	{
+		Uint32 blit_idx = AddPass(name, destination_resource, RG_ACCESS_CLEAR, -1, RG_ACCESS_NONE, std::move(record));
+		passes[blit_idx].blit_source = source_resource;
+		return blit_idx;
+	}
+
+	void RenderGraph::AddDependency(Uint32 pass_idx, Uint32 depends_on_idx)
+	{
+		passes[pass_idx].dependencies.push_back(depends_on_idx);
+	}
+
+	// Kahn's algorithm, among the ready passes the one added first goes next so independent passes keep their order
+	void RenderGraph::SortPasses()
+	{
+		order.clear();
+		std::vector<Uint32> pending_count(passes.size(), 0);
+		for (Uint32 i = 0; i < passes.size(); i++)
+			pending_count[i] = passes[i].dependencies.size();
+
+		std::vector<Uint8> is_scheduled(passes.size(), 0);
+		while (order.size() < passes.size())
+		{
+			Uint32 next_pass = passes.size();
+			for (Uint32 i = 0; i < passes.size(); i++)
+			{
+				if (!is_scheduled[i] && !pending_count[i])
+				{
+					next_pass = i;
+					break;
+				}
+			}
+
+			if (next_pass == passes.size())
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Render graph has a dependency cycle\n");
+				std::abort();
+			}
+
+			is_scheduled[next_pass] = 1;
+			order.push_back(next_pass);
+			for (Uint32 i = 0; i < passes.size(); i++)
+				for (Uint32 dependency : passes[i].dependencies)
+					if (dependency == next_pass)
+						pending_count[i]--;
+		}
+	}
+
+	// Same attachments and no clear halfway through, SDL can only clear when a pass begins
+	bool RenderGraph::CanMerge(const RenderGraphPass& group_pass, const RenderGraphPass& next_pass)
+	{
+		return group_pass.blit_source < 0 && next_pass.blit_source < 0 &&
+			group_pass.color_resource == next_pass.color_resource &&
+			group_pass.depth_resource == next_pass.depth_resource &&
+			next_pass.color_access != RG_ACCESS_CLEAR &&
+			next_pass.depth_access != RG_ACCESS_CLEAR;
+	}
+
+	// Loads only what an earlier pass or the previous frame left behind, stores only what a later pass or the presenter reads
+	void RenderGraph::ResolveOps(Uint32 resource_idx, RenderGraphAccess first_access, Uint32 group_end, SDL_GPULoadOp& out_load_op, SDL_GPUStoreOp& out_store_op)
+	{
+		RenderGraphResource& resource = resources[resource_idx];
+
+		bool is_read_later = resource.is_output;
+		for (Uint32 i = group_end; i < order.size() && !is_read_later; i++)
+		{
+			const RenderGraphPass& later_pass = passes[order[i]];
+			is_read_later = (later_pass.color_resource == resource_idx && later_pass.color_access != RG_ACCESS_CLEAR) ||
+				(later_pass.depth_resource == static_cast<Sint32>(resource_idx) && (later_pass.depth_access == RG_ACCESS_READ || later_pass.depth_access == RG_ACCESS_WRITE)) ||
+				later_pass.blit_source == static_cast<Sint32>(resource_idx);
+		}
+
+		// An attachment that is only bound to keep the pass compatible still has to carry its contents through
+		bool has_contents = resource.is_written || resource.keeps_contents;
+		if (first_access == RG_ACCESS_CLEAR)
+			out_load_op = SDL_GPU_LOADOP_CLEAR;
+		else if (has_contents && (first_access != RG_ACCESS_NONE || is_read_later))
+			out_load_op = SDL_GPU_LOADOP_LOAD;
+		else
+			out_load_op = SDL_GPU_LOADOP_DONT_CARE;
+
+		out_store_op = is_read_later ? SDL_GPU_STOREOP_STORE : SDL_GPU_STOREOP_DONT_CARE;
+	}
+
+	Uint32 RenderGraph::Execute(SDL_GPUCommandBuffer* cmd_buff)
+	{
+		BB3D_PROFILE_FUNCTION();
+		SortPasses();
+
+		Uint32 render_pass_count = 0;
+		for (Uint32 group_start = 0; group_start < order.size();)
+		{
+			Uint32 group_end = group_start + 1;
+			while (group_end < order.size() && CanMerge(passes[order[group_start]], passes[order[group_end]]))
+				group_end++;
+
+			const RenderGraphPass& first_pass = passes[order[group_start]];
+			if (first_pass.blit_source >= 0)
+			{
+				BB3D_PROFILE_ZONE(first_pass.name);
+				first_pass.record(cmd_buff, nullptr);
+				resources[first_pass.color_resource].is_written = true;
+				group_start = group_end;
+				continue;
+			}
+
+			// The first pass to touch an attachment inside the group decides how it is loaded
+			RenderGraphAccess depth_first_access = RG_ACCESS_NONE;
+			for (Uint32 i = group_start; i < group_end && depth_first_access == RG_ACCESS_NONE; i++)
+				depth_first_access = passes[order[i]].depth_access;
+
+			RenderGraphResource& color_resource = resources[first_pass.color_resource];
+			SDL_GPUColorTargetInfo color_target_info = {};
+			color_target_info.texture = color_resource.texture;
+			color_target_info.clear_color = color_resource.clear_color;
+			ResolveOps(first_pass.color_resource, first_pass.color_access, group_end, color_target_info.load_op, color_target_info.store_op);
+
+			SDL_GPUDepthStencilTargetInfo depth_stencil_target_info = {};
+			bool has_depth = first_pass.depth_resource >= 0;
+			if (has_depth)
+			{
+				RenderGraphResource& depth_resource = resources[first_pass.depth_resource];
+				depth_stencil_target_info.texture = depth_resource.texture;
+				depth_stencil_target_info.clear_depth = depth_resource.clear_depth;
+				ResolveOps(first_pass.depth_resource, depth_first_access, group_end, depth_stencil_target_info.load_op, depth_stencil_target_info.store_op);
+				depth_stencil_target_info.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+				depth_stencil_target_info.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+			}
+
+			SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(cmd_buff, &color_target_info, 1, has_depth ? &depth_stencil_target_info : nullptr);
+			if (!render_pass)
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to begin render pass for %s: %s\n", first_pass.name, SDL_GetError());
+				std::abort();
+			}
+
+			for (Uint32 i = group_start; i < group_end; i++)
+			{
+				BB3D_PROFILE_ZONE(passes[order[i]].name);
+				passes[order[i]].record(cmd_buff, render_pass);
+			}
+
+			SDL_EndGPURenderPass(render_pass);
+			render_pass_count++;
+
+			color_resource.is_written = true;
+			if (depth_first_access != RG_ACCESS_NONE)
+				resources[first_pass.depth_resource].is_written = true;
+
+			group_start = group_end;
+		}
+
+		return render_pass_count;
+	}
+}
\ No newline at end of file
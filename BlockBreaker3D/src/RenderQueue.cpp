@@ -0,0 +1,182 @@
+#include "Engine.h"
+#include <algorithm>
+
+#define SORTKEY_PIPELINE_SHIFT 60
+#define SORTKEY_MESH_SHIFT 52
+#define SORTKEY_LOD_SHIFT 48
+#define SORTKEY_TEXTURE_SHIFT 40
+#define SORTKEY_DEPTH_SHIFT 16
+#define SORTKEY_DEPTH_MAX 0xFFFFFF
+#define SORTKEY_DEPTH_RANGE 1000.0f // matches the far plane
+
+// A LOD is picked once its simplification error covers less than this many pixels, before the bias
+#define LOD_ERROR_PIXELS 1.0f
+#define LOD_MIN_DISTANCE 0.1f
+
+namespace BB3D
+{
+	// ________________________________ RenderQueue ________________________________
+	void RenderQueue::Build(std::vector<Entity>& entities, std::vector<Uint8>& visibility, std::vector<Mesh>& meshes, glm::vec3 view_pos, glm::vec3 view_dir, float pixels_per_unit, float lod_bias)
+	{
+		items.clear();
+
+		for (Uint32 i = 0; i < entities.size(); i++)
+		{
+			Entity& current_entity = entities[i];
+			if (!current_entity.is_active || !visibility[i])
+				continue;
+
+			RenderPipelineID pipeline = current_entity.is_shaded ? RenderPipelineID::MODELS_PHONG : RenderPipelineID::MODELS_NO_PHONG;
+
+			// Interpolated like the draw itself, so depth order matches what ends up on screen
+			glm::mat4 transform = current_entity.GetRenderTransform();
+			glm::vec3 render_position = glm::vec3(transform[3]);
+			float view_depth = glm::dot(render_position - view_pos, view_dir);
+
+			// Same scale as the culling sphere, so a stretched mesh picks its LOD by its longest axis
+			float max_scale = glm::max(glm::length(glm::vec3(transform[0])), glm::max(glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2]))));
+			float view_distance = glm::length(render_position - view_pos);
+			Uint8 lod = SelectLod(meshes[current_entity.mesh_type], max_scale, view_distance, pixels_per_unit, lod_bias);
+
+			items.push_back({ MakeSortKey(pipeline, current_entity.mesh_type, lod, current_entity.texture_type, view_depth), i });
+		}
+
+		// Front to back inside each state bucket
+		std::sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b)
+			{
+				return a.sort_key < b.sort_key;
+			}
+		);
+	}
+
+	// The coarsest LOD whose estimated error projects to under a pixel, a positive bias doubles that budget per step
+	// The baked error is an RMS distance, so individual spots can still pop by more than the budget
+	Uint8 RenderQueue::SelectLod(const Mesh& mesh, float world_scale, float view_distance, float pixels_per_unit, float lod_bias)
+	{
+		float error_budget = LOD_ERROR_PIXELS * std::exp2(lod_bias);
+		float error_scale = world_scale * pixels_per_unit / glm::max(view_distance, LOD_MIN_DISTANCE);
+
+		Uint8 lod = 0;
+		while (lod + 1u < mesh.lod_count && mesh.lods[lod + 1].error * error_scale <= error_budget)
+			lod++;
+
+		return lod;
+	}
+
+	Uint64 RenderQueue::MakeSortKey(RenderPipelineID pipeline, MeshType mesh, Uint8 lod, TextureType texture, float view_depth)
+	{
+		float depth_norm = view_depth / SORTKEY_DEPTH_RANGE;
+		if (depth_norm < 0.0f) depth_norm = 0.0f;
+		if (depth_norm > 1.0f) depth_norm = 1.0f;
+		Uint64 depth_bits = static_cast<Uint64>(depth_norm * SORTKEY_DEPTH_MAX);
+
+		return (static_cast<Uint64>(pipeline & 0xF) << SORTKEY_PIPELINE_SHIFT) |
+			(static_cast<Uint64>(mesh) << SORTKEY_MESH_SHIFT) |
+			(static_cast<Uint64>(lod & 0xF) << SORTKEY_LOD_SHIFT) |
+			(static_cast<Uint64>(texture) << SORTKEY_TEXTURE_SHIFT) |
+			(depth_bits << SORTKEY_DEPTH_SHIFT);
+	}
+
+	RenderPipelineID RenderQueue::GetPipeline(Uint64 sort_key)
+	{
+		return static_cast<RenderPipelineID>((sort_key >> SORTKEY_PIPELINE_SHIFT) & 0xF);
+	}
+
+	MeshType RenderQueue::GetMesh(Uint64 sort_key)
+	{
+		return static_cast<MeshType>((sort_key >> SORTKEY_MESH_SHIFT) & 0xFF);
+	}
+
+	Uint8 RenderQueue::GetLod(Uint64 sort_key)
+	{
+		return static_cast<Uint8>((sort_key >> SORTKEY_LOD_SHIFT) & 0xF);
+	}
+
+	// Pipeline, mesh and LOD decide the bound state and index range, texture and depth only order items inside a batch
+	Uint64 RenderQueue::GetStateBits(Uint64 sort_key)
+	{
+		return sort_key >> SORTKEY_LOD_SHIFT;
+	}
+
+	// ________________________________ RenderStateCache ________________________________
+	void RenderStateCache::Begin(SDL_GPURenderPass* new_render_pass, RenderStats* frame_stats)
+	{
+		render_pass = new_render_pass;
+		stats = frame_stats;
+
+		// Bindings do not survive across render passes
+		pipeline = nullptr;
+		vbo = nullptr;
+		ibo = nullptr;
+		vertex_storage_buff = nullptr;
+		fragment_sampler = {};
+	}
+
+	bool RenderStateCache::BindPipeline(SDL_GPUGraphicsPipeline* new_pipeline)
+	{
+		if (pipeline == new_pipeline)
+		{
+			stats->binds_saved++;
+			return false;
+		}
+
+		SDL_BindGPUGraphicsPipeline(render_pass, new_pipeline);
+		pipeline = new_pipeline;
+		stats->binds_issued++;
+		return true;
+	}
+
+	void RenderStateCache::BindVertexBuffer(SDL_GPUBuffer* new_vbo)
+	{
+		if (vbo == new_vbo)
+		{
+			stats->binds_saved++;
+			return;
+		}
+
+		SDL_GPUBufferBinding vbo_bind = { new_vbo, 0 };
+		SDL_BindGPUVertexBuffers(render_pass, 0, &vbo_bind, 1);
+		vbo = new_vbo;
+		stats->binds_issued++;
+	}
+
+	void RenderStateCache::BindIndexBuffer(SDL_GPUBuffer* new_ibo, SDL_GPUIndexElementSize index_size)
+	{
+		if (ibo == new_ibo)
+		{
+			stats->binds_saved++;
+			return;
+		}
+
+		SDL_GPUBufferBinding ibo_bind = { new_ibo, 0 };
+		SDL_BindGPUIndexBuffer(render_pass, &ibo_bind, index_size);
+		ibo = new_ibo;
+		stats->binds_issued++;
+	}
+
+	void RenderStateCache::BindVertexStorageBuffer(SDL_GPUBuffer* new_storage_buff)
+	{
+		if (vertex_storage_buff == new_storage_buff)
+		{
+			stats->binds_saved++;
+			return;
+		}
+
+		SDL_BindGPUVertexStorageBuffers(render_pass, 0, &new_storage_buff, 1);
+		vertex_storage_buff = new_storage_buff;
+		stats->binds_issued++;
+	}
+
+	void RenderStateCache::BindFragmentSampler(SDL_GPUTextureSamplerBinding new_sampler)
+	{
+		if (fragment_sampler.texture == new_sampler.texture && fragment_sampler.sampler == new_sampler.sampler)
+		{
+			stats->binds_saved++;
+			return;
+		}
+
+		SDL_BindGPUFragmentSamplers(render_pass, 0, &new_sampler, 1);
+		fragment_sampler = new_sampler;
+		stats->binds_issued++;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "Engine.h"
+#include <fstream>
+
+#define REPLAY_MAGIC "BB3R"
+#define REPLAY_VERSION 2
+
+// Tick flags
+#define REPLAY_TICK_KEYS 0x1
+#define REPLAY_TICK_MOUSEBTNS 0x2
+#define REPLAY_TICK_MOUSEPOS 0x4
+#define REPLAY_TICK_MOUSEREL 0x8
+
+namespace BB3D
+{
+	static void WriteBytes(std::vector<Uint8>& stream, const void* src, size_t size)
+	{
+		const Uint8* src_bytes = static_cast<const Uint8*>(src);
+		stream.insert(stream.end(), src_bytes, src_bytes + size);
+	}
+
+	static bool ReadBytes(const std::vector<Uint8>& stream, size_t& offset, void* dst, size_t size)
+	{
+		if (offset + size > stream.size())
+			return false;
+
+		std::memcpy(dst, stream.data() + offset, size);
+		offset += size;
+		return true;
+	}
+
+	// Writes a count followed by the index of every entry that flipped, returns false when nothing did
+	static bool WriteToggles(std::vector<Uint8>& stream, const bool* current, bool* last, Uint8 count)
+	{
+		Uint8 toggles[128];
+		Uint8 toggle_count = 0;
+		for (Uint8 i = 0; i < count; i++)
+		{
+			if (current[i] != last[i])
+			{
+				toggles[toggle_count++] = i;
+				last[i] = current[i];
+			}
+		}
+
+		if (!toggle_count)
+			return false;
+
+		stream.push_back(toggle_count);
+		WriteBytes(stream, toggles, toggle_count);
+		return true;
+	}
+
+	static bool ReadToggles(const std::vector<Uint8>& stream, size_t& offset, bool* state, Uint8 count)
+	{
+		Uint8 toggle_count = 0;
+		if (!ReadBytes(stream, offset, &toggle_count, 1))
+			return false;
+
+		for (Uint8 i = 0; i < toggle_count; i++)
+		{
+			Uint8 toggle_idx = 0;
+			if (!ReadBytes(stream, offset, &toggle_idx, 1) || toggle_idx >= count)
+				return false;
+
+			state[toggle_idx] = !state[toggle_idx];
+		}
+
+		return true;
+	}
+
+	void InputReplay::BeginRecording(const char* path, Uint64 record_seed, Uint32 record_tick_rate)
+	{
+		mode = ReplayMode::REPLAY_RECORD;
+		filepath = path;
+		seed = record_seed;
+		tick_rate = record_tick_rate;
+		tick_count = 0;
+		record_size = 0;
+		last_state = {};
+
+		// Opened up front so a bad path fails before the session rather than after it
+		record_file = SDL_IOFromFile(path, "wb");
+		if (!record_file)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to open replay file for writing at %s: %s\n", path, SDL_GetError());
+			std::abort();
+		}
+
+		stream.clear();
+		stream.reserve(4 * 1024);
+
+		Uint16 version = REPLAY_VERSION;
+		WriteBytes(stream, REPLAY_MAGIC, 4);
+		WriteBytes(stream, &version, sizeof(version));
+		WriteBytes(stream, &tick_rate, sizeof(tick_rate));
+		WriteBytes(stream, &seed, sizeof(seed));
+		FlushRecording();
+	}
+
+	void InputReplay::RecordTick(const InputState& input_state, Uint32 state_hash)
+	{
+		// Flags are patched in once the tick's payload is known
+		size_t flags_offset = stream.size();
+		stream.push_back(0);
+		Uint8 flags = 0;
+
+		WriteBytes(stream, &state_hash, sizeof(state_hash));
+
+		if (WriteToggles(stream, input_state.current_keys, last_state.current_keys, 128))
+			flags |= REPLAY_TICK_KEYS;
+
+		if (WriteToggles(stream, input_state.current_mousebtn, last_state.current_mousebtn, 12))
+			flags |= REPLAY_TICK_MOUSEBTNS;
+
+		if (input_state.current_mouse_x != last_state.current_mouse_x || input_state.current_mouse_y != last_state.current_mouse_y)
+		{
+			WriteBytes(stream, &input_state.current_mouse_x, sizeof(float));
+			WriteBytes(stream, &input_state.current_mouse_y, sizeof(float));
+			last_state.current_mouse_x = input_state.current_mouse_x;
+			last_state.current_mouse_y = input_state.current_mouse_y;
+			flags |= REPLAY_TICK_MOUSEPOS;
+		}
+
+		if (input_state.relx != 0.0f || input_state.rely != 0.0f)
+		{
+			WriteBytes(stream, &input_state.relx, sizeof(float));
+			WriteBytes(stream, &input_state.rely, sizeof(float));
+			flags |= REPLAY_TICK_MOUSEREL;
+		}
+
+		stream[flags_offset] = flags;
+		tick_count++;
+
+		// A crash only loses the last second of input
+		if (tick_count % tick_rate == 0)
+			FlushRecording();
+	}
+
+	void InputReplay::FlushRecording()
+	{
+		if (stream.empty())
+			return;
+
+		if (SDL_WriteIO(record_file, stream.data(), stream.size()) != stream.size() || !SDL_FlushIO(record_file))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to write replay file at %s: %s\n", filepath.c_str(), SDL_GetError());
+			std::abort();
+		}
+
+		record_size += stream.size();
+		stream.clear();
+	}
+
+	void InputReplay::EndRecording()
+	{
+		if (mode != ReplayMode::REPLAY_RECORD)
+			return;
+
+		FlushRecording();
+		SDL_CloseIO(record_file);
+		record_file = nullptr;
+		SDL_Log("OK: Recorded %u ticks (%llu bytes) to %s\n", tick_count, static_cast<unsigned long long>(record_size), filepath.c_str());
+
+		mode = ReplayMode::REPLAY_OFF;
+	}
+
+	void InputReplay::BeginPlayback(const char* path)
+	{
+		mode = ReplayMode::REPLAY_PLAYBACK;
+		filepath = path;
+		tick_count = 0;
+		is_desynced = false;
+
+		std::ifstream replay_f(filepath, std::ios::binary);
+		if (!replay_f)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to load replay file at: %s\n", path);
+			std::abort();
+		}
+
+		stream.assign(std::istreambuf_iterator<char>(replay_f), std::istreambuf_iterator<char>());
+
+		char magic[4] = {};
+		Uint16 version = 0;
+		read_offset = 0;
+		if (!ReadBytes(stream, read_offset, magic, 4) || std::memcmp(magic, REPLAY_MAGIC, 4) != 0 ||
+			!ReadBytes(stream, read_offset, &version, sizeof(version)) || version != REPLAY_VERSION ||
+			!ReadBytes(stream, read_offset, &tick_rate, sizeof(tick_rate)) ||
+			!ReadBytes(stream, read_offset, &seed, sizeof(seed)))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Replay file at %s is not a version %d BB3R file\n", path, REPLAY_VERSION);
+			std::abort();
+		}
+	}
+
+	bool InputReplay::PlaybackTick(InputState& input_state, Uint32 state_hash)
+	{
+		Uint8 flags = 0;
+		if (!ReadBytes(stream, read_offset, &flags, 1))
+			return false;
+
+		Uint32 recorded_hash = 0;
+		bool is_valid = ReadBytes(stream, read_offset, &recorded_hash, sizeof(recorded_hash));
+
+		// Everything after the first divergence follows from it, so only that one is worth reporting
+		if (is_valid && recorded_hash != state_hash && !is_desynced)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Replay %s desynced at tick %u, state hash %08x but %08x was recorded\n", filepath.c_str(), tick_count, state_hash, recorded_hash);
+			is_desynced = true;
+		}
+		if (flags & REPLAY_TICK_KEYS)
+			is_valid = is_valid && ReadToggles(stream, read_offset, input_state.current_keys, 128);
+
+		if (flags & REPLAY_TICK_MOUSEBTNS)
+			is_valid = is_valid && ReadToggles(stream, read_offset, input_state.current_mousebtn, 12);
+
+		if (flags & REPLAY_TICK_MOUSEPOS)
+		{
+			is_valid = is_valid && ReadBytes(stream, read_offset, &input_state.current_mouse_x, sizeof(float));
+			is_valid = is_valid && ReadBytes(stream, read_offset, &input_state.current_mouse_y, sizeof(float));
+		}
+
+		input_state.relx = 0.0f;
+		input_state.rely = 0.0f;
+		if (flags & REPLAY_TICK_MOUSEREL)
+		{
+			is_valid = is_valid && ReadBytes(stream, read_offset, &input_state.relx, sizeof(float));
+			is_valid = is_valid && ReadBytes(stream, read_offset, &input_state.rely, sizeof(float));
+		}
+
+		if (!is_valid)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Replay file %s is truncated at tick %u\n", filepath.c_str(), tick_count);
+			return false;
+		}
+
+		tick_count++;
+		return true;
+	}
+}
\ No newline at end of file
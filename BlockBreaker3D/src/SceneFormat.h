@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+// Baked scene layout shared by the engine and the SceneBaker tool
+// Header | Entities | Text fields | String data, loaded with one pass over each block and no parsing
+#define BAKED_SCENE_MAGIC 0x53334242 // "BB3S"
+#define BAKED_SCENE_VERSION 1
+#define BAKED_SCENE_EXTENSION ".bb3dscene"
+
+// Entity flags
+#define BAKED_ENTITY_SHADED 0x1
+#define BAKED_ENTITY_ACTIVE 0x2
+
+namespace BB3D
+{
+	// 40 bytes, mesh and texture hold MeshType and TextureType values
+	struct BakedSceneEntity
+	{
+		uint8_t mesh;
+		uint8_t texture;
+		uint8_t flags;
+		uint8_t pad;
+		float position[3];
+		float rotation[3];
+		float scale[3];
+	};
+
+	static_assert(sizeof(BakedSceneEntity) == 40, "BakedSceneEntity must stay tightly packed");
+
+	// Text is not null terminated, it lives in the string data block
+	struct BakedSceneText
+	{
+		uint32_t text_offset; // bytes into the string data
+		uint32_t text_length;
+		float position[2];
+		float color[4];
+		uint32_t is_visible;
+	};
+
+	static_assert(sizeof(BakedSceneText) == 36, "BakedSceneText must stay tightly packed");
+
+	struct BakedSceneHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t entity_count;
+		uint32_t text_count;
+		uint32_t string_size;
+
+		// Byte offsets from the start of the file
+		uint32_t entity_offset;
+		uint32_t text_offset;
+		uint32_t string_offset;
+	};
+
+	static_assert(sizeof(BakedSceneHeader) == 32, "BakedSceneHeader must stay tightly packed");
+}
\ No newline at end of file
@@ -1,9 +1,10 @@
 #include "Engine.h"
-#include <fstream>
 #include <iostream>
-#include <sstream>
 #include <iomanip>
+#include <cmath>
+#include <algorithm>
 #include "nlohmann/json.hpp"
+#include "SceneFormat.h"
 
 namespace BB3D
 {
@@ -13,62 +14,365 @@ namespace BB3D
 	bool is_dbg = false;
 
 	// Base scene implementation
+	Uint32 Scene::s_NextSceneID = 0;
+	Random Scene::s_Random = {};
+
+	// Fills the scene lists as the tokens stream past, no DOM and no repeated key lookups per component
+	// Depth 1 is the root object, 2 a section array, 3 an entity or text field, 4 one of its vectors
+	// Same schema as SceneBaker, every key is required so json and baked scenes can never load differently
+	struct SceneJSONHandler : nlohmann::json_sax<nlohmann::json>
+	{
+		enum SceneSection
+		{
+			SECTION_NONE,
+			SECTION_ENTITIES,
+			SECTION_TEXTFIELDS
+		};
+
+		enum SceneField
+		{
+			FIELD_NONE,
+			FIELD_MESH,
+			FIELD_TEXTURE,
+			FIELD_POSITION,
+			FIELD_ROTATION,
+			FIELD_SCALE,
+			FIELD_IS_SHADED,
+			FIELD_IS_ACTIVE,
+			FIELD_TEXT,
+			FIELD_COLOR,
+			FIELD_IS_VISIBLE
+		};
+
+		std::vector<Entity>& entities;
+		std::vector<UI_TextField>& text_fields;
+		SceneSection section = SECTION_NONE;
+		SceneField field = FIELD_NONE;
+		Uint32 depth = 0;
+		Uint32 component_idx = 0;
+		Uint32 seen_fields = 0; // bit per SceneField the current item has a valid value for
+		bool has_entities = false;
+		Entity pending_entity = {};
+		UI_TextField pending_text = {};
+		std::string error_msg;
+
+		SceneJSONHandler(std::vector<Entity>& scene_entities, std::vector<UI_TextField>& scene_text_fields) : entities(scene_entities), text_fields(scene_text_fields) {}
+
+		bool IsInItem() { return section != SECTION_NONE && depth == 3; }
+		bool IsInVector() { return section != SECTION_NONE && depth == 4; }
+		void MarkSeen() { seen_fields |= 1u << field; }
+
+		Uint32 GetComponentCount()
+		{
+			if (field == FIELD_POSITION)
+				return section == SECTION_ENTITIES ? 3 : 2;
+			if (field == FIELD_ROTATION || field == FIELD_SCALE)
+				return 3;
+			if (field == FIELD_COLOR)
+				return 4;
+			return 0;
+		}
+
+		static const char* GetFieldName(SceneField scene_field)
+		{
+			static const char* FIELD_NAMES[] = { "", "mesh", "texture", "position", "rotation", "scale", "is_shaded", "is_active", "text", "color", "is_visible" };
+			return FIELD_NAMES[scene_field];
+		}
+
+		void OnNumber(float value)
+		{
+			if (IsInItem())
+			{
+				if (section != SECTION_ENTITIES)
+					return;
+
+				if (field == FIELD_MESH)
+					pending_entity.mesh_type = static_cast<MeshType>(static_cast<int>(value));
+				else if (field == FIELD_TEXTURE)
+					pending_entity.texture_type = static_cast<TextureType>(static_cast<int>(value));
+				else
+					return;
+
+				MarkSeen();
+				return;
+			}
+
+			if (!IsInVector())
+				return;
+
+			Uint32 idx = component_idx++;
+			if (field == FIELD_POSITION && section == SECTION_ENTITIES && idx < 3)
+				pending_entity.position[idx] = value;
+			else if (field == FIELD_ROTATION && idx < 3)
+				pending_entity.rotation[idx] = value;
+			else if (field == FIELD_SCALE && idx < 3)
+				pending_entity.scale[idx] = value;
+			else if (field == FIELD_POSITION && section == SECTION_TEXTFIELDS && idx < 2)
+				pending_text.pos[idx] = value;
+			else if (field == FIELD_COLOR && idx < 4)
+				pending_text.color[idx] = value;
+		}
+
+		bool null() override { return true; }
+		bool number_integer(number_integer_t val) override { OnNumber(static_cast<float>(val)); return true; }
+		bool number_unsigned(number_unsigned_t val) override { OnNumber(static_cast<float>(val)); return true; }
+		bool number_float(number_float_t val, const string_t&) override { OnNumber(static_cast<float>(val)); return true; }
+		bool binary(binary_t&) override { return true; }
+
+		bool boolean(bool val) override
+		{
+			if (!IsInItem())
+				return true;
+
+			if (field == FIELD_IS_SHADED && section == SECTION_ENTITIES)
+				pending_entity.is_shaded = val;
+			else if (field == FIELD_IS_ACTIVE && section == SECTION_ENTITIES)
+				pending_entity.is_active = val;
+			else if (field == FIELD_IS_VISIBLE && section == SECTION_TEXTFIELDS)
+				pending_text.is_visible = val;
+			else
+				return true;
+
+			MarkSeen();
+			return true;
+		}
+
+		bool string(string_t& val) override
+		{
+			if (IsInItem() && field == FIELD_TEXT && section == SECTION_TEXTFIELDS)
+			{
+				pending_text.text = std::move(val);
+				MarkSeen();
+			}
+			return true;
+		}
+
+		bool key(string_t& val) override
+		{
+			if (depth == 1)
+			{
+				section = val == "entities" ? SECTION_ENTITIES : val == "textfields" ? SECTION_TEXTFIELDS : SECTION_NONE;
+				has_entities = has_entities || section == SECTION_ENTITIES;
+				return true;
+			}
+
+			if (!IsInItem())
+				return true;
+
+			if (val == "mesh") field = FIELD_MESH;
+			else if (val == "texture") field = FIELD_TEXTURE;
+			else if (val == "position") field = FIELD_POSITION;
+			else if (val == "rotation") field = FIELD_ROTATION;
+			else if (val == "scale") field = FIELD_SCALE;
+			else if (val == "is_shaded") field = FIELD_IS_SHADED;
+			else if (val == "is_active") field = FIELD_IS_ACTIVE;
+			else if (val == "text") field = FIELD_TEXT;
+			else if (val == "color") field = FIELD_COLOR;
+			else if (val == "is_visible") field = FIELD_IS_VISIBLE;
+			else field = FIELD_NONE;
+			return true;
+		}
+
+		bool start_object(std::size_t) override
+		{
+			depth++;
+			if (!IsInItem())
+				return true;
+
+			pending_entity = {};
+			pending_entity.transform = glm::mat4(1.0f);
+			pending_entity.velocity = glm::vec3(0.0f);
+			pending_text = {};
+			field = FIELD_NONE;
+			seen_fields = 0;
+			return true;
+		}
+
+		bool end_object() override
+		{
+			if (IsInItem())
+			{
+				const SceneField* required_fields = nullptr;
+				Uint32 required_count = 0;
+				static const SceneField ENTITY_FIELDS[] = { FIELD_MESH, FIELD_TEXTURE, FIELD_POSITION, FIELD_ROTATION, FIELD_SCALE, FIELD_IS_SHADED, FIELD_IS_ACTIVE };
+				static const SceneField TEXT_FIELDS[] = { FIELD_TEXT, FIELD_POSITION, FIELD_COLOR, FIELD_IS_VISIBLE };
+				if (section == SECTION_ENTITIES)
+				{
+					required_fields = ENTITY_FIELDS;
+					required_count = sizeof(ENTITY_FIELDS) / sizeof(ENTITY_FIELDS[0]);
+				}
+				else
+				{
+					required_fields = TEXT_FIELDS;
+					required_count = sizeof(TEXT_FIELDS) / sizeof(TEXT_FIELDS[0]);
+				}
+
+				for (Uint32 i = 0; i < required_count; i++)
+				{
+					if (seen_fields & (1u << required_fields[i]))
+						continue;
+
+					size_t item_idx = section == SECTION_ENTITIES ? entities.size() : text_fields.size();
+					error_msg = std::string(section == SECTION_ENTITIES ? "entity " : "text field ") + std::to_string(item_idx) + " is missing a valid \"" + GetFieldName(required_fields[i]) + "\"";
+					return false;
+				}
+
+				if (section == SECTION_ENTITIES)
+					entities.push_back(pending_entity);
+				else
+					text_fields.push_back(std::move(pending_text));
+			}
+
+			depth--;
+			if (depth == 0 && !has_entities)
+			{
+				error_msg = "scene has no \"entities\" array";
+				return false;
+			}
+			return true;
+		}
+
+		bool start_array(std::size_t) override
+		{
+			depth++;
+			component_idx = 0;
+			return true;
+		}
+
+		bool end_array() override
+		{
+			// Short vectors count as missing, longer ones only have their leading components read like the baker does
+			if (IsInVector() && GetComponentCount() && component_idx >= GetComponentCount())
+				MarkSeen();
+
+			depth--;
+			if (depth == 1)
+				section = SECTION_NONE;
+			return true;
+		}
+
+		bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) override
+		{
+			error_msg = ex.what();
+			return false;
+		}
+	};
+
 	Scene::Scene(const char* filepath, std::function<void(SceneType)> trans_to_callback)
 	{
+		BB3D_PROFILE_FUNCTION();
 		m_TransToCallback = trans_to_callback;
+		m_SceneID = s_NextSceneID++;
+
+		// Shipped scenes are baked by SceneBaker, json is still read directly for authoring and generated scenes
+		std::string scene_path = filepath;
+		std::string baked_extension = BAKED_SCENE_EXTENSION;
+		if (scene_path.size() >= baked_extension.size() && scene_path.compare(scene_path.size() - baked_extension.size(), baked_extension.size(), baked_extension) == 0)
+			ReadBakedScene(filepath);
+		else
+			ParseSceneJSON(filepath);
+	}
 
-		m_SceneEntities.reserve(16);
-		m_SceneElements.reserve(16);
-		m_SceneTextfields.reserve(16);
+	void Scene::ReadBakedScene(const char* filepath)
+	{
+		MappedFile scene_file;
+		if (!scene_file.Open(filepath))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map baked scene %s\n", filepath);
+			std::abort();
+		}
 
-		// Parse scene data
-		std::ifstream scene_f(filepath);
-		if (!scene_f)
+		BakedSceneHeader header = {};
+		if (scene_file.size < sizeof(BakedSceneHeader))
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to load scene json at: %s\n", filepath);
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked scene %s is truncated\n", filepath);
 			std::abort();
 		}
 
-		std::stringstream json_buffer;
-		json_buffer << scene_f.rdbuf();
-		std::string json_string = json_buffer.str();
+		std::memcpy(&header, scene_file.data, sizeof(BakedSceneHeader));
 
-		nlohmann::json scene_data;
-		scene_data = nlohmann::json::parse(json_string);
+		if (header.magic != BAKED_SCENE_MAGIC || header.version != BAKED_SCENE_VERSION)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked scene %s has an unknown format or version %u, rebuild the SceneBaker target\n", filepath, header.version);
+			std::abort();
+		}
 
-		if (!scene_data.is_object())
+		Uint64 entities_end = static_cast<Uint64>(header.entity_offset) + static_cast<Uint64>(header.entity_count) * sizeof(BakedSceneEntity);
+		Uint64 texts_end = static_cast<Uint64>(header.text_offset) + static_cast<Uint64>(header.text_count) * sizeof(BakedSceneText);
+		Uint64 strings_end = static_cast<Uint64>(header.string_offset) + header.string_size;
+		if (entities_end > scene_file.size || texts_end > scene_file.size || strings_end > scene_file.size)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to parse scene json at: %s\n", "my filepath");
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked scene %s is truncated\n", filepath);
 			std::abort();
 		}
 
-		// Build entities and push to list
-		for (const auto& loaded_entity : scene_data["entities"])
+		// Counts are known up front, so each list is allocated exactly once
+		m_SceneEntities.reserve(header.entity_count);
+		for (Uint32 i = 0; i < header.entity_count; i++)
+		{
+			BakedSceneEntity baked_entity;
+			std::memcpy(&baked_entity, scene_file.data + header.entity_offset + i * sizeof(BakedSceneEntity), sizeof(BakedSceneEntity));
+
+			Entity new_entity = {};
+			new_entity.mesh_type = static_cast<MeshType>(baked_entity.mesh);
+			new_entity.texture_type = static_cast<TextureType>(baked_entity.texture);
+			new_entity.transform = glm::mat4(1.0f);
+			new_entity.position = glm::vec3(baked_entity.position[0], baked_entity.position[1], baked_entity.position[2]);
+			new_entity.rotation = glm::vec3(baked_entity.rotation[0], baked_entity.rotation[1], baked_entity.rotation[2]);
+			new_entity.scale = glm::vec3(baked_entity.scale[0], baked_entity.scale[1], baked_entity.scale[2]);
+			new_entity.velocity = glm::vec3(0.0f);
+			new_entity.is_shaded = (baked_entity.flags & BAKED_ENTITY_SHADED) != 0;
+			new_entity.is_active = (baked_entity.flags & BAKED_ENTITY_ACTIVE) != 0;
+
+			m_SceneEntities.push_back(new_entity);
+		}
+
+		const char* string_data = reinterpret_cast<const char*>(scene_file.data + header.string_offset);
+		m_SceneTextfields.reserve(header.text_count);
+		for (Uint32 i = 0; i < header.text_count; i++)
 		{
-			MeshType mesh_t = loaded_entity["mesh"];
-			TextureType texture_t = loaded_entity["texture"];
-			glm::vec3 pos = { loaded_entity["position"][0], loaded_entity["position"][1], loaded_entity["position"][2] };
-			glm::vec3 rot = { loaded_entity["rotation"][0], loaded_entity["rotation"][1], loaded_entity["rotation"][2] };
-			glm::vec3 scale = { loaded_entity["scale"][0], loaded_entity["scale"][1], loaded_entity["scale"][2] };
-			bool is_shaded = loaded_entity["is_shaded"];
-			bool is_active = loaded_entity["is_active"];
+			BakedSceneText baked_text;
+			std::memcpy(&baked_text, scene_file.data + header.text_offset + i * sizeof(BakedSceneText), sizeof(BakedSceneText));
+			if (static_cast<Uint64>(baked_text.text_offset) + baked_text.text_length > header.string_size)
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked scene %s text field %u runs past the string data\n", filepath, i);
+				std::abort();
+			}
 
-			// MeshType | TextureType | Transform Matrix | Pos | Rot | Scale | Velocity | Apply Shading?
-			m_SceneEntities.push_back({ mesh_t, texture_t, glm::mat4(1.0f), pos, rot, scale, glm::vec3(0.0f), is_shaded, is_active });
+			m_SceneTextfields.push_back({
+				std::string(string_data + baked_text.text_offset, baked_text.text_length),
+				glm::vec2(baked_text.position[0], baked_text.position[1]),
+				glm::vec4(baked_text.color[0], baked_text.color[1], baked_text.color[2], baked_text.color[3]),
+				baked_text.is_visible != 0
+			});
 		}
 
-		// Build UI Elems and push to list
+		scene_file.Close();
+	}
 
-		// Build UI Textfields and push to list
-		for (const auto& loaded_text : scene_data["textfields"])
+	void Scene::ParseSceneJSON(const char* filepath)
+	{
+		m_SceneEntities.reserve(16);
+		m_SceneElements.reserve(16);
+		m_SceneTextfields.reserve(16);
+
+		MappedFile scene_file;
+		if (!scene_file.Open(filepath))
 		{
-			std::string text = loaded_text["text"];
-			glm::vec2 pos = { loaded_text["position"][0], loaded_text["position"][1] };
-			glm::vec4 color = { loaded_text["color"][0], loaded_text["color"][1], loaded_text["color"][2], loaded_text["color"][3] };
-			bool is_visible = loaded_text["is_visible"];
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to load scene json at: %s\n", filepath);
+			std::abort();
+		}
+
+		// Parsed straight out of the mapping, the file is never copied into a string
+		const char* json_begin = reinterpret_cast<const char*>(scene_file.data);
+		SceneJSONHandler scene_handler(m_SceneEntities, m_SceneTextfields);
+		bool is_parsed = nlohmann::json::sax_parse(json_begin, json_begin + scene_file.size, &scene_handler);
+		scene_file.Close();
 
-			// MeshType | TextureType | Transform Matrix | Pos | Rot | Scale | Velocity | Apply Shading?
-			m_SceneTextfields.push_back({ text, pos, color, is_visible });
+		if (!is_parsed)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to parse scene json at: %s: %s\n", filepath, scene_handler.error_msg.c_str());
+			std::abort();
 		}
 	}
 
@@ -92,6 +396,40 @@ namespace BB3D
 		return m_SceneCam;
 	}
 
+	Uint32 Scene::GetSceneID()
+	{
+		return m_SceneID;
+	}
+
+	// FNV-1a over what the simulation moves, in the ball and blocks that is position, velocity and whether a block is still up
+	// Bitwise on purpose, a replay is only trusted if it reproduces the exact same floats
+	Uint32 Scene::GetStateHash()
+	{
+		Uint32 state_hash = 2166136261u;
+		auto hash_bytes = [&state_hash](const void* src, size_t size)
+		{
+			const Uint8* src_bytes = static_cast<const Uint8*>(src);
+			for (size_t i = 0; i < size; i++)
+				state_hash = (state_hash ^ src_bytes[i]) * 16777619u;
+		};
+
+		hash_bytes(&m_SceneID, sizeof(m_SceneID));
+		for (const Entity& current_entity : m_SceneEntities)
+		{
+			Uint8 is_active = current_entity.is_active;
+			hash_bytes(&is_active, sizeof(is_active));
+			hash_bytes(&current_entity.position, sizeof(current_entity.position));
+			hash_bytes(&current_entity.velocity, sizeof(current_entity.velocity));
+		}
+
+		return state_hash;
+	}
+
+	void Scene::SeedRandom(Uint64 seed)
+	{
+		s_Random.Seed(seed);
+	}
+
 	// ________________________________ MenuScene ________________________________
 	MenuScene::MenuScene(const char* filepath, std::function<void(SceneType)> trans_to_callback) : Scene(filepath, trans_to_callback)
 	{
@@ -111,6 +449,8 @@ namespace BB3D
 
 	void MenuScene::Update(InputState& input_state, float delta_time)
 	{
+		BB3D_PROFILE_FUNCTION();
+
 		// Input
 		CheckMouseInput(input_state, delta_time);
 
@@ -140,19 +480,19 @@ namespace BB3D
 		if (!in_play)
 		{
 			m_IsButtonsDown[0] = false;
-			m_SceneTextfields[2].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[2].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		if (!in_options)
 		{
 			m_IsButtonsDown[1] = false;
-			m_SceneTextfields[3].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[3].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		if (!in_quit)
 		{
 			m_IsButtonsDown[2] = false;
-			m_SceneTextfields[4].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[4].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		// TODO Clean this up a bit
@@ -164,7 +504,7 @@ namespace BB3D
 		{
 			printf("Pressed Play Button Down!\n");
 			m_IsButtonsDown[0] = true;
-			m_SceneTextfields[2].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[2].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -174,7 +514,7 @@ namespace BB3D
 		{
 			printf("Released Play Button Up!\n");
 			m_IsButtonsDown[0] = false;
-			m_SceneTextfields[2].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[2].SetColor(NOT_SELECTED_ELEM_COLOR);
 			m_TransToCallback(SceneType::GAMEPLAY);
 			return;
 		}
@@ -187,7 +527,7 @@ namespace BB3D
 		{
 			printf("Pressed Options Button Down!\n");
 			m_IsButtonsDown[1] = true;
-			m_SceneTextfields[3].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[3].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -197,7 +537,7 @@ namespace BB3D
 		{
 			printf("Released Options Button Up!\n");
 			m_IsButtonsDown[1] = false;
-			m_SceneTextfields[3].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[3].SetColor(NOT_SELECTED_ELEM_COLOR);
 			m_TransToCallback(SceneType::OPTIONS);
 			return;
 		}
@@ -210,7 +550,7 @@ namespace BB3D
 		{
 			printf("Pressed Quit Button Down!\n");
 			m_IsButtonsDown[2] = true;
-			m_SceneTextfields[4].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[4].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -220,7 +560,7 @@ namespace BB3D
 		{
 			printf("Released Quit Button Up!\n");
 			m_IsButtonsDown[2] = false;
-			m_SceneTextfields[4].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[4].SetColor(NOT_SELECTED_ELEM_COLOR);
 			m_TransToCallback(SceneType::QUIT);
 			return;
 		}
@@ -237,7 +577,7 @@ namespace BB3D
 
 
 	// ________________________________ OptionsScene ________________________________
-	OptionsScene::OptionsScene(const char* filepath, std::function<void(SceneType)> trans_to_callback, std::function<void()> toggle_skybox_callback) : Scene(filepath, trans_to_callback)
+	OptionsScene::OptionsScene(const char* filepath, std::function<void(SceneType)> trans_to_callback, std::function<void()> toggle_skybox_callback, std::function<std::string()> cycle_resolution_callback, const std::string& resolution_label) : Scene(filepath, trans_to_callback)
 	{
 		m_SceneCam.pos = glm::vec3(0.0f, 1.0f, 4.0f);
 		m_SceneCam.front = glm::vec3(0.0f, 0.0f, -1.0f);
@@ -248,6 +588,8 @@ namespace BB3D
 		std::memset(m_IsButtonsDown, 0, sizeof(m_IsButtonsDown));
 
 		m_ToggleSkyboxCallback = toggle_skybox_callback;
+		m_CycleResolutionCallback = cycle_resolution_callback;
+		m_SceneTextfields[2].SetText(resolution_label);
 	}
 
 	OptionsScene::~OptionsScene()
@@ -257,6 +599,8 @@ namespace BB3D
 
 	void OptionsScene::Update(InputState& input_state, float delta_time)
 	{
+		BB3D_PROFILE_FUNCTION();
+
 		CheckMouseInput(input_state, delta_time);
 
 	}
@@ -271,25 +615,25 @@ namespace BB3D
 		if (!in_skybox)
 		{
 			m_IsButtonsDown[0] = false;
-			m_SceneTextfields[0].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[0].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		if (!in_music)
 		{
 			m_IsButtonsDown[1] = false;
-			m_SceneTextfields[1].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[1].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		if (!in_res)
 		{
 			m_IsButtonsDown[2] = false;
-			m_SceneTextfields[2].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[2].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		if (!in_back)
 		{
 			m_IsButtonsDown[3] = false;
-			m_SceneTextfields[3].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[3].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
 		// TODO Clean this up a bit
@@ -301,7 +645,7 @@ namespace BB3D
 		{
 			printf("Pressed Skybox Button Down!\n");
 			m_IsButtonsDown[0] = true;
-			m_SceneTextfields[0].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[0].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -311,19 +655,19 @@ namespace BB3D
 		{
 			printf("Released Skybox Button Up!\n");
 			m_IsButtonsDown[0] = false;
-			m_SceneTextfields[0].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[0].SetColor(NOT_SELECTED_ELEM_COLOR);
 			m_ToggleSkyboxCallback();
 		}
 
-		// Resolution Selector
+		// Music Selector
 		if (
 			input_state.current_mousebtn[1] && !input_state.prev_mousebtn[1] &&
 			in_music &&
 			!m_IsButtonsDown[1])
 		{
-			printf("Pressed Res Button Down!\n");
+			printf("Pressed Music Button Down!\n");
 			m_IsButtonsDown[1] = true;
-			m_SceneTextfields[1].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[1].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -331,20 +675,20 @@ namespace BB3D
 			in_music &&
 			m_IsButtonsDown[1])
 		{
-			printf("Released Res Button Up!\n");
+			printf("Released Music Button Up!\n");
 			m_IsButtonsDown[1] = false;
-			m_SceneTextfields[1].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[1].SetColor(NOT_SELECTED_ELEM_COLOR);
 		}
 
-		// Music Selector
+		// Resolution Selector
 		if (
 			input_state.current_mousebtn[1] && !input_state.prev_mousebtn[1] &&
 			in_res &&
 			!m_IsButtonsDown[2])
 		{
-			printf("Pressed Music Button Down!\n");
+			printf("Pressed Res Button Down!\n");
 			m_IsButtonsDown[2] = true;
-			m_SceneTextfields[2].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[2].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -352,9 +696,10 @@ namespace BB3D
 			in_res &&
 			m_IsButtonsDown[2])
 		{
-			printf("Released Music Button Up!\n");
+			printf("Released Res Button Up!\n");
 			m_IsButtonsDown[2] = false;
-			m_SceneTextfields[2].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[2].SetColor(NOT_SELECTED_ELEM_COLOR);
+			m_SceneTextfields[2].SetText(m_CycleResolutionCallback());
 		}
 
 		// Back Button
@@ -365,7 +710,7 @@ namespace BB3D
 		{
 			printf("Pressed Back Button Down!\n");
 			m_IsButtonsDown[3] = true;
-			m_SceneTextfields[3].color = SELECTED_ELEM_COLOR;
+			m_SceneTextfields[3].SetColor(SELECTED_ELEM_COLOR);
 		}
 
 		if (
@@ -375,7 +720,7 @@ namespace BB3D
 		{
 			printf("Released Back Button Up!\n");
 			m_IsButtonsDown[3] = false;
-			m_SceneTextfields[3].color = NOT_SELECTED_ELEM_COLOR;
+			m_SceneTextfields[3].SetColor(NOT_SELECTED_ELEM_COLOR);
 			m_TransToCallback(SceneType::MAIN_MENU);
 			return;
 		}
@@ -390,6 +735,61 @@ namespace BB3D
 		return false;
 	}
 
+	// ________________________________ BenchScene ________________________________
+	BenchScene::BenchScene(const char* filepath, std::function<void(SceneType)> trans_to_callback, Uint32 path_ticks) : Scene(filepath, trans_to_callback)
+	{
+		m_PathTicks = SDL_max(path_ticks, 1u);
+		m_TickCount = 0;
+
+		// Orbit around the bounds of everything active so any generated scene stays in view
+		glm::vec3 bounds_min = glm::vec3(0.0f);
+		glm::vec3 bounds_max = glm::vec3(0.0f);
+		bool has_bounds = false;
+		for (Entity& current_entity : m_SceneEntities)
+		{
+			current_entity.UpdateTransform();
+			if (!current_entity.is_active)
+				continue;
+
+			glm::vec3 entity_min = current_entity.position - glm::abs(current_entity.scale);
+			glm::vec3 entity_max = current_entity.position + glm::abs(current_entity.scale);
+			bounds_min = has_bounds ? glm::min(bounds_min, entity_min) : entity_min;
+			bounds_max = has_bounds ? glm::max(bounds_max, entity_max) : entity_max;
+			has_bounds = true;
+		}
+
+		m_OrbitCenter = (bounds_min + bounds_max) * 0.5f;
+		m_OrbitRadius = SDL_max(glm::length(bounds_max - bounds_min) * 0.5f, 1.0f);
+
+		PlaceCamera();
+	}
+
+	BenchScene::~BenchScene()
+	{
+
+	}
+
+	void BenchScene::Update(InputState&, float)
+	{
+		BB3D_PROFILE_FUNCTION();
+
+		// Driven by ticks rather than time so every run sees the same views in the same frames
+		m_TickCount++;
+		PlaceCamera();
+	}
+
+	void BenchScene::PlaceCamera()
+	{
+		// One lap over the run, pulling in and out and rising and falling so culling and LODs change along the way
+		float lap_angle = glm::radians(360.0f) * static_cast<float>(m_TickCount % m_PathTicks) / static_cast<float>(m_PathTicks);
+		float orbit_distance = m_OrbitRadius * (1.2f + 0.5f * std::sin(lap_angle * 2.0f));
+		float orbit_height = m_OrbitRadius * (0.4f + 0.3f * std::sin(lap_angle * 3.0f));
+
+		m_SceneCam.pos = m_OrbitCenter + glm::vec3(std::cos(lap_angle) * orbit_distance, orbit_height, std::sin(lap_angle) * orbit_distance);
+		m_SceneCam.front = glm::normalize(m_OrbitCenter - m_SceneCam.pos);
+		m_SceneCam.up = glm::vec3(0.0f, 1.0f, 0.0f);
+	}
+
 	// ________________________________ GameScene ________________________________
 	GameScene::GameScene(const char* filepath, std::function<void(SceneType)> trans_to_callback) : Scene(filepath, trans_to_callback)
 	{
@@ -437,8 +837,9 @@ namespace BB3D
 				m_SceneEntities.push_back(new_block);
 			}
 		}
-		
-		
+
+		// Cells match the block pitch so the ball only ever looks at its neighbours
+		m_BlockGrid.Build(m_SceneEntities, MeshType::BLOCK, glm::vec2(2.0f, 1.0f), glm::vec2(0.5f, 0.0f));
 	}
 
 	GameScene::~GameScene()
@@ -448,6 +849,8 @@ namespace BB3D
 
 	void GameScene::Update(InputState& input_state, float delta_time)
 	{
+		BB3D_PROFILE_FUNCTION();
+
 		// Main gameplay loop logic
 		// ___________________________________
 		//	Input
@@ -466,13 +869,13 @@ namespace BB3D
 		{
 			is_dbg = true;
 			// TODO improve this
-			m_SceneTextfields[1].is_visible = true;
+			m_SceneTextfields[1].SetVisible(true);
 		}
 
 		if (input_state.current_keys[SDL_SCANCODE_MINUS] && !input_state.prev_keys[SDL_SCANCODE_MINUS])
 		{
 			is_dbg = false;
-			m_SceneTextfields[1].is_visible = false;
+			m_SceneTextfields[1].SetVisible(false);
 		}
 
 		UpdatePaddle(input_state, delta_time);
@@ -503,19 +906,18 @@ namespace BB3D
 		direction.z = sin(glm::radians(m_SceneCam.yaw)) * cos(glm::radians(m_SceneCam.pitch));
 		m_SceneCam.front = glm::normalize(direction);
 
-		const bool* keys = SDL_GetKeyboardState(0);
-
 		const float camera_speed = 2.0f * delta_time;
 
+		// Read from the input state rather than SDL so the fly camera is recorded and replayed too
 		if (is_dbg)
 		{
-			if (keys[SDL_SCANCODE_W])
+			if (input_state.current_keys[SDL_SCANCODE_W])
 				m_SceneCam.pos += camera_speed * m_SceneCam.front;
-			if (keys[SDL_SCANCODE_A])
+			if (input_state.current_keys[SDL_SCANCODE_A])
 				m_SceneCam.pos -= glm::normalize(glm::cross(m_SceneCam.front, m_SceneCam.up)) * camera_speed;
-			if (keys[SDL_SCANCODE_S])
+			if (input_state.current_keys[SDL_SCANCODE_S])
 				m_SceneCam.pos -= camera_speed * m_SceneCam.front;
-			if (keys[SDL_SCANCODE_D])
+			if (input_state.current_keys[SDL_SCANCODE_D])
 				m_SceneCam.pos += glm::normalize(glm::cross(m_SceneCam.front, m_SceneCam.up)) * camera_speed;
 		}
 		// ___________________________________
@@ -523,11 +925,24 @@ namespace BB3D
 
 	void GameScene::CheckCollisions()
 	{
-		// Blocks
-		for (Entity& current_entity : m_SceneEntities)
+		BB3D_PROFILE_FUNCTION();
+
+		// Blocks, only the cells the ball swept through this tick
+		// Twice the radius covers the reach of a hit plus the push out of any block it hits
+		glm::vec2 ball_prev = glm::vec2(m_SceneEntities[2].prev_position.x, m_SceneEntities[2].prev_position.z);
+		glm::vec2 ball_curr = glm::vec2(m_SceneEntities[2].position.x, m_SceneEntities[2].position.z);
+		glm::vec2 sweep_min = glm::min(ball_prev, ball_curr) - glm::vec2(2.0f * m_BallState.radius);
+		glm::vec2 sweep_max = glm::max(ball_prev, ball_curr) + glm::vec2(2.0f * m_BallState.radius);
+
+		m_BlockCandidates.clear();
+		m_BlockGrid.Query(sweep_min, sweep_max, m_BlockCandidates);
+
+		// Keep the order of a full scan so hits resolve the same way on every run and in replays
+		std::sort(m_BlockCandidates.begin(), m_BlockCandidates.end());
+
+		for (Uint32 entity_idx : m_BlockCandidates)
 		{
-			if (current_entity.mesh_type != MeshType::BLOCK)
-				continue;
+			Entity& current_entity = m_SceneEntities[entity_idx];
 			if (!current_entity.is_active)
 				continue;
 
@@ -535,6 +950,7 @@ namespace BB3D
 			if (result.is_colliding)
 			{
 				current_entity.is_active = false;
+				m_BlockGrid.Remove(entity_idx, current_entity.position);
 
 				if (result.collision_dir == VelocityDir::LEFT || result.collision_dir == VelocityDir::RIGHT)
 				{
@@ -658,7 +1074,8 @@ namespace BB3D
 	{
 		m_BallState.is_stuck = true;
 		m_SceneEntities[2].position = { m_SceneEntities[0].position.x, m_SceneEntities[0].position.y, m_SceneEntities[0].position.z - m_BallState.radius };
-		m_SceneEntities[2].velocity.x = 3.5f;
+		// Launch side is rolled from the seeded generator, replays roll the same sides
+		m_SceneEntities[2].velocity.x = s_Random.NextFloat() < 0.5f ? -3.5f : 3.5f;
 		m_SceneEntities[2].velocity.z = -3.4f;
 		m_PaddleHitCount = 0;
 	}
@@ -56,4 +56,57 @@ namespace BB3D
 		return new_shader;
 	}
 
+	SDL_GPUComputePipeline* CreateComputePipelineFromFile(
+		SDL_GPUDevice* device,
+		const char* file_path,
+		Uint32 readonly_storage_buffer_count,
+		Uint32 readwrite_storage_buffer_count,
+		Uint32 uniform_buffer_count,
+		Uint32 threadcount_x
+	)
+	{
+		SDL_GPUComputePipeline* new_pipeline;
+
+		SDL_GPUShaderFormat supported_formats = SDL_GetGPUShaderFormats(device);
+		if (!(supported_formats & SDL_GPU_SHADERFORMAT_SPIRV))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Device context does not support the target shader format (SPIR-V)");
+			std::abort();
+		}
+
+		size_t source_size = 0;
+		void* shader_source = SDL_LoadFile(file_path, &source_size);
+		if (!shader_source)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to locate file at: %s\n", file_path);
+			std::abort();
+		}
+
+		// Compute shaders are baked straight into their pipeline, there is no separate shader object
+		SDL_GPUComputePipelineCreateInfo pipeline_create_info = {};
+		pipeline_create_info.code = static_cast<Uint8*>(shader_source);
+		pipeline_create_info.code_size = source_size;
+		pipeline_create_info.entrypoint = "main";
+		pipeline_create_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
+		pipeline_create_info.num_readonly_storage_buffers = readonly_storage_buffer_count;
+		pipeline_create_info.num_readwrite_storage_buffers = readwrite_storage_buffer_count;
+		pipeline_create_info.num_uniform_buffers = uniform_buffer_count;
+		pipeline_create_info.threadcount_x = threadcount_x;
+		pipeline_create_info.threadcount_y = 1;
+		pipeline_create_info.threadcount_z = 1;
+
+		new_pipeline = SDL_CreateGPUComputePipeline(
+			device,
+			&pipeline_create_info
+		);
+		if (!new_pipeline)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU compute pipeline: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		SDL_free(shader_source);
+
+		return new_pipeline;
+	}
 }
\ No newline at end of file
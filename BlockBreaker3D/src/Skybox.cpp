@@ -0,0 +1,177 @@
+#include "Engine.h"
+
+namespace BB3D
+{
+	void SkyboxCache::Init(const std::vector<std::string>& filepaths, Uint64 budget_bytes)
+	{
+		slots.clear();
+		for (const std::string& filepath : filepaths)
+		{
+			SkyboxSlot new_slot = {};
+			new_slot.filepath = filepath;
+			slots.push_back(new_slot);
+		}
+
+		vram_budget = budget_bytes;
+		vram_resident = 0;
+		use_counter = 0;
+		pending_state = SKYBOX_LOAD_IDLE;
+	}
+
+	void SkyboxCache::AdoptTexture(Uint32 skybox_idx, TextureAsset& loaded_asset)
+	{
+		SkyboxSlot& slot = slots[skybox_idx];
+		slot.texture = loaded_asset.texture;
+		slot.props = loaded_asset.props;
+		slot.vram_size = loaded_asset.GetStagingSize();
+		slot.last_used = ++use_counter;
+		vram_resident += slot.vram_size;
+
+		displayed_idx = skybox_idx;
+		requested_idx = skybox_idx;
+	}
+
+	void SkyboxCache::Request(Uint32 skybox_idx)
+	{
+		requested_idx = skybox_idx;
+	}
+
+	void SkyboxCache::Update(SDL_GPUDevice* device, ThreadPool& thread_pool)
+	{
+		BB3D_PROFILE_FUNCTION();
+
+		if (pending_state == SKYBOX_LOAD_STAGED)
+			FinishLoad(device);
+
+		// The current skybox stays up until the requested one is resident
+		if (slots[requested_idx].texture)
+			displayed_idx = requested_idx;
+		else if (pending_state == SKYBOX_LOAD_IDLE)
+			BeginLoad(device, thread_pool, requested_idx);
+
+		slots[displayed_idx].last_used = ++use_counter;
+		EvictOverBudget(device);
+	}
+
+	SkyboxSlot& SkyboxCache::GetDisplayed()
+	{
+		return slots[displayed_idx];
+	}
+
+	void SkyboxCache::Release(SDL_GPUDevice* device)
+	{
+		// The thread pool is shut down first, so no worker can still be touching the pending load
+		pending_asset.file.Close();
+		pending_texels.clear();
+		pending_state = SKYBOX_LOAD_IDLE;
+
+		for (SkyboxSlot& slot : slots)
+		{
+			if (slot.texture)
+				SDL_ReleaseGPUTexture(device, slot.texture);
+			slot.texture = nullptr;
+		}
+		vram_resident = 0;
+	}
+
+	void SkyboxCache::BeginLoad(SDL_GPUDevice* device, ThreadPool& thread_pool, Uint32 skybox_idx)
+	{
+		pending_idx = skybox_idx;
+		pending_asset = {};
+		pending_asset.filepath = slots[skybox_idx].filepath;
+		pending_state = SKYBOX_LOAD_READING;
+
+		// Read and stage off the main thread into plain memory, the GPU side is finished in Update
+		thread_pool.Submit([this, device] {
+			BB3D_PROFILE_ZONE("SkyboxCache::BackgroundLoad");
+			pending_asset.Read();
+			pending_asset.SelectUploadFormat(device);
+			pending_texels.resize(pending_asset.GetStagingSize());
+			pending_asset.staging_offset = 0;
+			pending_asset.Stage(pending_texels.data());
+			pending_state = SKYBOX_LOAD_STAGED;
+		});
+	}
+
+	void SkyboxCache::FinishLoad(SDL_GPUDevice* device)
+	{
+		BB3D_PROFILE_FUNCTION();
+
+		pending_asset.CreateTexture(device);
+
+		SDL_GPUTransferBufferCreateInfo skybox_transfer_create_info = {};
+		skybox_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+		skybox_transfer_create_info.size = pending_texels.size();
+		SDL_GPUTransferBuffer* skybox_trans_buff = SDL_CreateGPUTransferBuffer(device, &skybox_transfer_create_info);
+		if (!skybox_trans_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create transfer buffer for skybox %s: %s\n", pending_asset.filepath.c_str(), SDL_GetError());
+			std::abort();
+		}
+
+		void* skybox_trans_ptr = SDL_MapGPUTransferBuffer(device, skybox_trans_buff, false);
+		if (!skybox_trans_ptr)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map transfer buffer for skybox %s: %s\n", pending_asset.filepath.c_str(), SDL_GetError());
+			std::abort();
+		}
+
+		std::memcpy(skybox_trans_ptr, pending_texels.data(), pending_texels.size());
+		SDL_UnmapGPUTransferBuffer(device, skybox_trans_buff);
+
+		// Submitted ahead of this frame's commands on the same queue, no fence needed before sampling it
+		SDL_GPUCommandBuffer* skybox_copy_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
+		if (!skybox_copy_cmd_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to acquire command buffer for skybox upload: %s\n", SDL_GetError());
+			std::abort();
+		}
+
+		SDL_GPUCopyPass* skybox_copy_pass = SDL_BeginGPUCopyPass(skybox_copy_cmd_buff);
+		pending_asset.Upload(skybox_copy_pass, skybox_trans_buff);
+		SDL_EndGPUCopyPass(skybox_copy_pass);
+		if (!SDL_SubmitGPUCommandBuffer(skybox_copy_cmd_buff))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit skybox upload: %s\n", SDL_GetError());
+			std::abort();
+		}
+		SDL_ReleaseGPUTransferBuffer(device, skybox_trans_buff);
+
+		SkyboxSlot& slot = slots[pending_idx];
+		slot.texture = pending_asset.texture;
+		slot.props = pending_asset.props;
+		slot.vram_size = pending_texels.size();
+		slot.last_used = ++use_counter;
+		vram_resident += slot.vram_size;
+
+		pending_texels.clear();
+		pending_texels.shrink_to_fit();
+		pending_state = SKYBOX_LOAD_IDLE;
+	}
+
+	void SkyboxCache::EvictOverBudget(SDL_GPUDevice* device)
+	{
+		while (vram_resident > vram_budget)
+		{
+			// Least recently displayed first, the displayed skybox is never evicted even if it alone is over budget
+			SkyboxSlot* lru_slot = nullptr;
+			for (Uint32 i = 0; i < slots.size(); i++)
+			{
+				if (!slots[i].texture || i == displayed_idx)
+					continue;
+
+				if (!lru_slot || slots[i].last_used < lru_slot->last_used)
+					lru_slot = &slots[i];
+			}
+
+			if (!lru_slot)
+				return;
+
+			// Release is deferred by SDL until in flight frames are done sampling it
+			SDL_ReleaseGPUTexture(device, lru_slot->texture);
+			lru_slot->texture = nullptr;
+			vram_resident -= lru_slot->vram_size;
+			lru_slot->vram_size = 0;
+		}
+	}
+}
\ No newline at end of file
@@ -1,123 +1,282 @@
 #include "Engine.h"
 #include <iostream>
-#include <stb_image.h>
 
 namespace BB3D
 {
-	SDL_GPUTexture* CreateAndLoadCubeMapToGPU(SDL_GPUDevice* device, std::array<std::string, 6> filepaths)
+	static void DecodeBC1Block(const Uint8* block, Uint8* out_texels, Uint32 row_pitch, Uint32 block_w, Uint32 block_h)
 	{
-		SDL_GPUTexture* new_cubemap_texture = {};
+		Uint16 color0, color1;
+		Uint32 indices;
+		std::memcpy(&color0, block, 2);
+		std::memcpy(&color1, block + 2, 2);
+		std::memcpy(&indices, block + 4, 4);
+
+		Uint8 palette[4][4] = {};
+		Uint16 endpoints[2] = { color0, color1 };
+		for (int e = 0; e < 2; e++)
+		{
+			palette[e][0] = static_cast<Uint8>(((endpoints[e] >> 11) & 0x1F) * 255 / 31);
+			palette[e][1] = static_cast<Uint8>(((endpoints[e] >> 5) & 0x3F) * 255 / 63);
+			palette[e][2] = static_cast<Uint8>((endpoints[e] & 0x1F) * 255 / 31);
+			palette[e][3] = 255;
+		}
 
-		unsigned char* cube_faces_img_data[6];
-		Image cube_faces_img_props = {};
+		// color0 <= color1 is the 3 colour mode with transparent black
+		for (int c = 0; c < 3; c++)
+		{
+			if (color0 > color1)
+			{
+				palette[2][c] = static_cast<Uint8>((2 * palette[0][c] + palette[1][c]) / 3);
+				palette[3][c] = static_cast<Uint8>((palette[0][c] + 2 * palette[1][c]) / 3);
+			}
+			else
+			{
+				palette[2][c] = static_cast<Uint8>((palette[0][c] + palette[1][c]) / 2);
+				palette[3][c] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = color0 > color1 ? 255 : 0;
 
-		// TODO - Enforce cubemap props are the same per face
+		for (Uint32 y = 0; y < block_h; y++)
+		{
+			for (Uint32 x = 0; x < block_w; x++)
+			{
+				Uint32 palette_idx = (indices >> ((y * 4 + x) * 2)) & 0x3;
+				std::memcpy(out_texels + y * row_pitch + x * 4, palette[palette_idx], 4);
+			}
+		}
+	}
+
+	static void DecodeBC4Block(const Uint8* block, Uint8* out_texels, Uint32 row_pitch, Uint32 block_w, Uint32 block_h)
+	{
+		Uint8 palette[8] = { block[0], block[1] };
+		if (block[0] > block[1])
+		{
+			for (int p = 1; p < 7; p++)
+				palette[p + 1] = static_cast<Uint8>(((7 - p) * block[0] + p * block[1]) / 7);
+		}
+		else
+		{
+			for (int p = 1; p < 5; p++)
+				palette[p + 1] = static_cast<Uint8>(((5 - p) * block[0] + p * block[1]) / 5);
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		Uint64 indices = 0;
 		for (int i = 0; i < 6; i++)
+			indices |= static_cast<Uint64>(block[2 + i]) << (i * 8);
+
+		for (Uint32 y = 0; y < block_h; y++)
 		{
-			stbi_set_flip_vertically_on_load(false);
-			cube_faces_img_data[i] = stbi_load(
-				filepaths[i].c_str(), 
-				&cube_faces_img_props.x, 
-				&cube_faces_img_props.y,
-				&cube_faces_img_props.channels,
-				4
-			);
-
-			if (!cube_faces_img_data[i])
+			for (Uint32 x = 0; x < block_w; x++)
+				out_texels[y * row_pitch + x] = palette[(indices >> ((y * 4 + x) * 3)) & 0x7];
+		}
+	}
+
+	// CPU fallback for devices without BCn sampling, expands a compressed level into its uncompressed format
+	static void DecodeBlockCompressed(BakedTextureFormat format, const Uint8* src, Uint8* dst, Uint32 width, Uint32 height)
+	{
+		Uint32 texel_size = format == BAKED_FORMAT_BC1 ? 4 : 1;
+		Uint32 row_pitch = width * texel_size;
+		Uint32 blocks_x = (width + 3) / 4;
+		Uint32 blocks_y = (height + 3) / 4;
+
+		for (Uint32 block_y = 0; block_y < blocks_y; block_y++)
+		{
+			for (Uint32 block_x = 0; block_x < blocks_x; block_x++)
 			{
-				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to load cubemap texture face file from: %s | idx = %d\n", filepaths[i].c_str(), i);
-				std::abort();
+				const Uint8* block = src + (block_y * blocks_x + block_x) * 8;
+				Uint8* out_texels = dst + block_y * 4 * row_pitch + block_x * 4 * texel_size;
+
+				// Edge blocks only write the texels that exist
+				Uint32 block_w = SDL_min(4u, width - block_x * 4);
+				Uint32 block_h = SDL_min(4u, height - block_y * 4);
+
+				if (format == BAKED_FORMAT_BC1)
+					DecodeBC1Block(block, out_texels, row_pitch, block_w, block_h);
+				else
+					DecodeBC4Block(block, out_texels, row_pitch, block_w, block_h);
 			}
 		}
+	}
 
-		SDL_GPUTextureCreateInfo cubemap_info = {};
-		cubemap_info.type = SDL_GPU_TEXTURETYPE_CUBE;
-		cubemap_info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-		cubemap_info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-		cubemap_info.width = cube_faces_img_props.x;
-		cubemap_info.height = cube_faces_img_props.y;
-		cubemap_info.layer_count_or_depth = 6;
-		cubemap_info.num_levels = 1;
-
-		new_cubemap_texture = SDL_CreateGPUTexture(device, &cubemap_info);
-		if (!new_cubemap_texture)
+	static SDL_GPUTextureFormat GetGPUTextureFormat(BakedTextureFormat format)
+	{
+		switch (format)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU cubemap texture: %s\n", SDL_GetError());
+		case BAKED_FORMAT_RGBA8:
+			return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+		case BAKED_FORMAT_R8:
+			return SDL_GPU_TEXTUREFORMAT_R8_UNORM;
+		case BAKED_FORMAT_BC1:
+			return SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+		case BAKED_FORMAT_BC4:
+			return SDL_GPU_TEXTUREFORMAT_BC4_R_UNORM;
+		}
+		return SDL_GPU_TEXTUREFORMAT_INVALID;
+	}
+
+	static SDL_GPUTextureType GetGPUTextureType(BakedTextureType type)
+	{
+		switch (type)
+		{
+		case BAKED_TEXTURE_2D:
+			return SDL_GPU_TEXTURETYPE_2D;
+		case BAKED_TEXTURE_2D_ARRAY:
+			return SDL_GPU_TEXTURETYPE_2D_ARRAY;
+		case BAKED_TEXTURE_CUBE:
+			return SDL_GPU_TEXTURETYPE_CUBE;
+		}
+		return SDL_GPU_TEXTURETYPE_2D;
+	}
+
+	void TextureAsset::Read()
+	{
+		BB3D_PROFILE_ZONE("TextureAsset::Read");
+
+		// PNGs are baked offline by TextureBaker, mips and block compression are already in the file
+		if (!file.Open(filepath.c_str()))
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map baked texture %s\n", filepath.c_str());
 			std::abort();
 		}
 
-		SDL_GPUTransferBufferCreateInfo cubemap_transfer_create_info = {};
-		cubemap_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-		cubemap_transfer_create_info.size = (4 * (cube_faces_img_props.x * cube_faces_img_props.y)); // face size in bytes
-		SDL_GPUTransferBuffer* cubemap_trans_buff = SDL_CreateGPUTransferBuffer(device, &cubemap_transfer_create_info);
-		if (!cubemap_trans_buff)
+		if (file.size >= sizeof(BakedTextureHeader))
+			std::memcpy(&header, file.data, sizeof(BakedTextureHeader));
+
+		if (header.magic != BAKED_TEXTURE_MAGIC || header.version != BAKED_TEXTURE_VERSION || header.format > BAKED_FORMAT_BC4 || header.type > BAKED_TEXTURE_CUBE)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create transfer buffer for File -> GPU Texture: %s\n", SDL_GetError());
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked texture %s has an unknown format or version, rebuild the TextureBaker target\n", filepath.c_str());
 			std::abort();
 		}
 
-		for (int i = 0; i < 6; i++)
+		Uint32 subresource_count = header.level_count * header.layer_count;
+		Uint64 table_end = sizeof(BakedTextureHeader) + static_cast<Uint64>(sizeof(BakedTextureSubresource)) * subresource_count;
+		if (!subresource_count || table_end > file.size)
 		{
-			SDL_GPUCommandBuffer* cubemap_copy_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
-			if (!cubemap_copy_cmd_buff)
-			{
-				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to acquire command buffer for copying to GPU texture: %s\n", SDL_GetError());
-				std::abort();
-			}
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked texture %s is truncated\n", filepath.c_str());
+			std::abort();
+		}
 
-			SDL_GPUCopyPass* cubemap_copy_pass = SDL_BeginGPUCopyPass(cubemap_copy_cmd_buff);
-			if (!cubemap_copy_pass)
+		subresources = reinterpret_cast<const BakedTextureSubresource*>(file.data + sizeof(BakedTextureHeader));
+		for (Uint32 level = 0; level < header.level_count; level++)
+		{
+			Uint32 baked_size = GetBakedTextureSize(header.format, SDL_max(header.width >> level, 1u), SDL_max(header.height >> level, 1u));
+			for (Uint32 layer = 0; layer < header.layer_count; layer++)
 			{
-				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to begin copy pass: %s\n", SDL_GetError());
-				std::abort();
+				const BakedTextureSubresource& subresource = subresources[level * header.layer_count + layer];
+				if (subresource.size != baked_size || static_cast<Uint64>(subresource.offset) + subresource.size > file.size)
+				{
+					SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Baked texture %s has a corrupt subresource at level %u layer %u\n", filepath.c_str(), level, layer);
+					std::abort();
+				}
 			}
+		}
 
-			void* cubemap_trans_ptr = SDL_MapGPUTransferBuffer(device, cubemap_trans_buff, false);
-			if (!cubemap_trans_ptr)
-			{
-				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map transfer buffer for File -> GPU Texture: %s\n", SDL_GetError());
-				std::abort();
-			}
+		upload_format = header.format;
+		props.x = header.width;
+		props.y = header.height;
+		props.channels = GetDecodedFormat(header.format) == BAKED_FORMAT_R8 ? 1 : 4;
+	}
 
-			std::memcpy(cubemap_trans_ptr, cube_faces_img_data[i], (4 * (cube_faces_img_props.x * cube_faces_img_props.y)));
-
-			SDL_UnmapGPUTransferBuffer(device, cubemap_trans_buff);
-
-			SDL_GPUTextureTransferInfo cubemap_trans_info = {};
-			cubemap_trans_info.offset = 0;
-			cubemap_trans_info.transfer_buffer = cubemap_trans_buff;
-			cubemap_trans_info.pixels_per_row = cube_faces_img_props.x;
-			//cubemap_trans_info.rows_per_layer = 1;
-			SDL_GPUTextureRegion cubemap_trans_region = {};
-			cubemap_trans_region.texture = new_cubemap_texture;
-			cubemap_trans_region.w = cube_faces_img_props.x;
-			cubemap_trans_region.h = cube_faces_img_props.y;
-			cubemap_trans_region.d = 1;
-			cubemap_trans_region.layer = SDL_GPU_CUBEMAPFACE_POSITIVEX + i;
-			SDL_UploadToGPUTexture(cubemap_copy_pass, &cubemap_trans_info, &cubemap_trans_region, false);
-
-			SDL_EndGPUCopyPass(cubemap_copy_pass);
-			SDL_GPUFence* upload_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(cubemap_copy_cmd_buff);
-			if (!upload_fence)
-			{
-				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit copy command buffer to GPU Texture and acquire fence: %s\n", SDL_GetError());
-				std::abort();
-			}
+	void TextureAsset::SelectUploadFormat(SDL_GPUDevice* device)
+	{
+		upload_format = header.format;
+		if (IsBlockCompressed(header.format) && !SDL_GPUTextureSupportsFormat(device, GetGPUTextureFormat(header.format), GetGPUTextureType(header.type), SDL_GPU_TEXTUREUSAGE_SAMPLER))
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Device cannot sample block compressed %s, decoding on the CPU\n", filepath.c_str());
+			upload_format = GetDecodedFormat(header.format);
+		}
+	}
 
-			SDL_WaitForGPUFences(device, true, &upload_fence, 1);
-			SDL_ReleaseGPUFence(device, upload_fence);
+	Uint32 TextureAsset::GetStagingSize()
+	{
+		Uint32 staging_size = 0;
+		for (Uint32 level = 0; level < header.level_count; level++)
+		{
+			Uint32 level_w = SDL_max(header.width >> level, 1u);
+			Uint32 level_h = SDL_max(header.height >> level, 1u);
+			staging_size += GetBakedTextureSize(upload_format, level_w, level_h) * header.layer_count;
 		}
 
-		// Free stbi image data
-		for (int i = 0; i < 6; i++)
+		return staging_size;
+	}
+
+	void TextureAsset::CreateTexture(SDL_GPUDevice* device)
+	{
+		SDL_GPUTextureCreateInfo tex_info = {};
+		tex_info.type = GetGPUTextureType(header.type);
+		tex_info.format = GetGPUTextureFormat(upload_format);
+		tex_info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+		tex_info.width = header.width;
+		tex_info.height = header.height;
+		tex_info.layer_count_or_depth = header.layer_count;
+		tex_info.num_levels = header.level_count;
+		texture = SDL_CreateGPUTexture(device, &tex_info);
+		if (!texture)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU texture for %s: %s\n", filepath.c_str(), SDL_GetError());
+			std::abort();
+		}
+	}
+
+	void TextureAsset::Stage(Uint8* staging_ptr)
+	{
+		BB3D_PROFILE_ZONE("TextureAsset::Stage");
+
+		// Subresources keep the file order, level then layer
+		Uint32 level_offset = staging_offset;
+		for (Uint32 level = 0; level < header.level_count; level++)
 		{
-			stbi_image_free(cube_faces_img_data[i]);
+			Uint32 level_w = SDL_max(header.width >> level, 1u);
+			Uint32 level_h = SDL_max(header.height >> level, 1u);
+			Uint32 level_upload_size = GetBakedTextureSize(upload_format, level_w, level_h);
+
+			for (Uint32 layer = 0; layer < header.layer_count; layer++)
+			{
+				const Uint8* baked_texels = file.data + subresources[level * header.layer_count + layer].offset;
+				if (upload_format == header.format)
+					std::memcpy(staging_ptr + level_offset, baked_texels, level_upload_size);
+				else
+					DecodeBlockCompressed(header.format, baked_texels, staging_ptr + level_offset, level_w, level_h);
+
+				level_offset += level_upload_size;
+			}
 		}
+	}
 
-		SDL_ReleaseGPUTransferBuffer(device, cubemap_trans_buff);
+	void TextureAsset::Upload(SDL_GPUCopyPass* copy_pass, SDL_GPUTransferBuffer* trans_buff)
+	{
+		Uint32 level_offset = staging_offset;
+		for (Uint32 level = 0; level < header.level_count; level++)
+		{
+			Uint32 level_w = SDL_max(header.width >> level, 1u);
+			Uint32 level_h = SDL_max(header.height >> level, 1u);
+			Uint32 level_upload_size = GetBakedTextureSize(upload_format, level_w, level_h);
 
+			for (Uint32 layer = 0; layer < header.layer_count; layer++)
+			{
+				SDL_GPUTextureTransferInfo tex_trans_info = {};
+				tex_trans_info.offset = level_offset;
+				tex_trans_info.transfer_buffer = trans_buff;
+				SDL_GPUTextureRegion tex_trans_region = {};
+				tex_trans_region.texture = texture;
+				tex_trans_region.mip_level = level;
+				tex_trans_region.layer = layer;
+				tex_trans_region.w = level_w;
+				tex_trans_region.h = level_h;
+				tex_trans_region.d = 1;
+				SDL_UploadToGPUTexture(copy_pass, &tex_trans_info, &tex_trans_region, false);
+
+				level_offset += level_upload_size;
+			}
+		}
 
-		return new_cubemap_texture;
+		// Already staged, the mapping is no longer needed
+		subresources = nullptr;
+		file.Close();
 	}
 
 	SDL_GPUTexture* CreateDepthTestTexture(SDL_GPUDevice* device, int render_target_w, int render_target_h)
@@ -142,98 +301,73 @@ namespace BB3D
 		return new_depth_texture;
 	}
 
-	SDL_GPUTexture* CreateAndLoadTextureToGPU(SDL_GPUDevice* device, const char* filepath)
+	// Offscreen target the 3D passes draw into before it is scaled onto the swapchain
+	SDL_GPUTexture* CreateColorTargetTexture(SDL_GPUDevice* device, SDL_GPUTextureFormat format, int render_target_w, int render_target_h)
 	{
-		SDL_GPUTexture* new_texture = {};
-		Image loaded_img = {};
-
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char* image_data = stbi_load(filepath, &loaded_img.x, &loaded_img.y, &loaded_img.channels, 4);
-		if (!image_data)
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to load texture file from: %s\n", filepath);
-			std::abort();
-		}
+		SDL_GPUTexture* new_color_texture = {};
 
 		SDL_GPUTextureCreateInfo tex_info = {};
 		tex_info.type = SDL_GPU_TEXTURETYPE_2D;
-		tex_info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-		tex_info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-		tex_info.width = loaded_img.x;
-		tex_info.height = loaded_img.y;
+		tex_info.format = format;
+		tex_info.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+		tex_info.width = render_target_w;
+		tex_info.height = render_target_h;
 		tex_info.layer_count_or_depth = 1;
 		tex_info.num_levels = 1;
-		new_texture = SDL_CreateGPUTexture(device, &tex_info);
-		if (!new_texture)
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU texture: %s\n", SDL_GetError());
-			std::abort();
-		}
-
-		SDL_GPUTransferBufferCreateInfo tex_transfer_create_info = {};
-		tex_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-		tex_transfer_create_info.size = 4 * (loaded_img.x * loaded_img.y);
-		SDL_GPUTransferBuffer* tex_trans_buff = SDL_CreateGPUTransferBuffer(device, &tex_transfer_create_info);
-		if (!tex_trans_buff)
+		new_color_texture = SDL_CreateGPUTexture(device, &tex_info);
+		if (!new_color_texture)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create transfer buffer for File -> GPU Texture: %s\n", SDL_GetError());
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU color target texture: %s\n", SDL_GetError());
 			std::abort();
 		}
 
-		void* tex_trans_ptr = SDL_MapGPUTransferBuffer(device, tex_trans_buff, false);
-		if (!tex_trans_ptr)
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map transfer buffer for File -> GPU Texture: %s\n", SDL_GetError());
-			std::abort();
-		}
-
-		std::memcpy(tex_trans_ptr, image_data, 4 * (loaded_img.x * loaded_img.y));
-		SDL_UnmapGPUTransferBuffer(device, tex_trans_buff);
+		return new_color_texture;
+	}
 
-		SDL_GPUCommandBuffer* tex_copy_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
-		if (!tex_copy_cmd_buff)
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to acquire command buffer for copying to GPU texture: %s\n", SDL_GetError());
-			std::abort();
-		}
+	// ________________________________ SamplerCache ________________________________
+	Uint32 SamplerDesc::GetKey() const
+	{
+		// Filter (1) | Mip Mode (1) | Address Mode (2) | Anisotropy (5)
+		return static_cast<Uint32>(filter) | static_cast<Uint32>(mip_mode) << 1 | static_cast<Uint32>(address_mode) << 2 | static_cast<Uint32>(max_anisotropy & 0x1F) << 4;
+	}
 
-		SDL_GPUCopyPass* tex_copy_pass = SDL_BeginGPUCopyPass(tex_copy_cmd_buff);
-		if (!tex_copy_pass)
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to begin copy pass: %s\n", SDL_GetError());
-			std::abort();
-		}
+	SDL_GPUSampler* SamplerCache::Get(SDL_GPUDevice* device, const SamplerDesc& desc)
+	{
+		Uint32 sampler_key = desc.GetKey();
+		auto cached_sampler = samplers.find(sampler_key);
+		if (cached_sampler != samplers.end())
+			return cached_sampler->second;
 
-		SDL_GPUTextureTransferInfo tex_trans_info = {};
-		tex_trans_info.offset = 0;
-		tex_trans_info.transfer_buffer = tex_trans_buff;
-		SDL_GPUTextureRegion tex_trans_region = {};
-		tex_trans_region.texture = new_texture;
-		tex_trans_region.w = loaded_img.x;
-		tex_trans_region.h = loaded_img.y;
-		tex_trans_region.d = 1;
-		SDL_UploadToGPUTexture(tex_copy_pass, &tex_trans_info, &tex_trans_region, false);
-		SDL_EndGPUCopyPass(tex_copy_pass);
-		if (!SDL_SubmitGPUCommandBuffer(tex_copy_cmd_buff))
+		SDL_GPUSamplerCreateInfo sampler_info = {};
+		sampler_info.min_filter = desc.filter;
+		sampler_info.mag_filter = desc.filter;
+		sampler_info.mipmap_mode = desc.mip_mode;
+		sampler_info.address_mode_u = desc.address_mode;
+		sampler_info.address_mode_v = desc.address_mode;
+		sampler_info.address_mode_w = desc.address_mode;
+		// Zero would clamp every lookup to the base level
+		sampler_info.min_lod = 0.0f;
+		sampler_info.max_lod = SAMPLER_LOD_UNCLAMPED;
+		sampler_info.enable_anisotropy = desc.max_anisotropy > 1;
+		sampler_info.max_anisotropy = static_cast<float>(desc.max_anisotropy);
+
+		SDL_GPUSampler* new_sampler = SDL_CreateGPUSampler(device, &sampler_info);
+		if (!new_sampler)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit copy command buffer to GPU Texture: %s\n", SDL_GetError());
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create GPU sampler: %s\n", SDL_GetError());
 			std::abort();
 		}
-		stbi_image_free(image_data);
-		SDL_ReleaseGPUTransferBuffer(device, tex_trans_buff);
 
-		return new_texture;
+		samplers[sampler_key] = new_sampler;
+		return new_sampler;
 	}
 
-	SDL_GPUSampler* CreateSampler(SDL_GPUDevice* device, SDL_GPUFilter texture_filter)
+	void SamplerCache::Release(SDL_GPUDevice* device)
 	{
-		SDL_GPUSampler* new_sampler = {};
-		SDL_GPUSamplerCreateInfo sampler_info = {};
-		sampler_info.min_filter = texture_filter;
-		sampler_info.mag_filter = texture_filter;
-		new_sampler = SDL_CreateGPUSampler(device, &sampler_info);
+		for (auto& [sampler_key, sampler] : samplers)
+			SDL_ReleaseGPUSampler(device, sampler);
 
-		return new_sampler;
+		samplers.clear();
 	}
 
 	SDL_GPUTexture* CreateAndLoadFontAtlasTextureToGPU(SDL_GPUDevice* device, const Uint32* atlas_buffer, Image atlas_props)
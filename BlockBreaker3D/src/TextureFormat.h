@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+
+// Baked texture layout shared by the engine and the TextureBaker tool
+// Header | Subresource table | Texel data, subresources are ordered by level then layer
+#define BAKED_TEXTURE_MAGIC 0x54334242 // "BB3T"
+#define BAKED_TEXTURE_VERSION 1
+#define BAKED_TEXTURE_EXTENSION ".bb3dtex"
+
+namespace BB3D
+{
+	enum BakedTextureFormat : uint32_t
+	{
+		BAKED_FORMAT_RGBA8 = 0x0,
+		BAKED_FORMAT_R8 = 0x1,
+		// 4x4 blocks, 8 bytes each
+		BAKED_FORMAT_BC1 = 0x2,
+		BAKED_FORMAT_BC4 = 0x3,
+	};
+
+	enum BakedTextureType : uint32_t
+	{
+		BAKED_TEXTURE_2D = 0x0,
+		BAKED_TEXTURE_2D_ARRAY = 0x1,
+		BAKED_TEXTURE_CUBE = 0x2,
+	};
+
+	struct BakedTextureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		BakedTextureFormat format;
+		BakedTextureType type;
+		uint32_t width;
+		uint32_t height;
+		uint32_t layer_count;
+		uint32_t level_count;
+	};
+
+	struct BakedTextureSubresource
+	{
+		// Byte offset from the start of the file
+		uint32_t offset;
+		uint32_t size;
+	};
+
+	static_assert(sizeof(BakedTextureHeader) == 32, "BakedTextureHeader must stay tightly packed");
+	static_assert(sizeof(BakedTextureSubresource) == 8, "BakedTextureSubresource must stay tightly packed");
+
+	inline bool IsBlockCompressed(BakedTextureFormat format)
+	{
+		return format == BAKED_FORMAT_BC1 || format == BAKED_FORMAT_BC4;
+	}
+
+	// Uncompressed equivalent used when the device cannot sample the block format
+	inline BakedTextureFormat GetDecodedFormat(BakedTextureFormat format)
+	{
+		if (format == BAKED_FORMAT_BC1)
+			return BAKED_FORMAT_RGBA8;
+		if (format == BAKED_FORMAT_BC4)
+			return BAKED_FORMAT_R8;
+		return format;
+	}
+
+	inline uint32_t GetBakedTextureSize(BakedTextureFormat format, uint32_t width, uint32_t height)
+	{
+		switch (format)
+		{
+		case BAKED_FORMAT_RGBA8:
+			return width * height * 4;
+		case BAKED_FORMAT_R8:
+			return width * height;
+		case BAKED_FORMAT_BC1:
+		case BAKED_FORMAT_BC4:
+			return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+		}
+		return 0;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include "Engine.h"
+
+namespace BB3D
+{
+	void ThreadPool::Init(Uint32 thread_count)
+	{
+		is_stopping = false;
+		busy_count = 0;
+
+		workers.reserve(thread_count);
+		for (Uint32 i = 0; i < thread_count; i++)
+			workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+
+	void ThreadPool::Submit(std::function<void()> job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobs_mutex);
+			jobs.push_back(std::move(job));
+		}
+		jobs_cv.notify_one();
+	}
+
+	void ThreadPool::Wait()
+	{
+		std::unique_lock<std::mutex> lock(jobs_mutex);
+		idle_cv.wait(lock, [this] { return jobs.empty() && busy_count == 0; });
+	}
+
+	void ThreadPool::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(jobs_mutex);
+			is_stopping = true;
+		}
+		jobs_cv.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		workers.clear();
+		jobs.clear();
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(jobs_mutex);
+				jobs_cv.wait(lock, [this] { return is_stopping || !jobs.empty(); });
+				if (is_stopping)
+					return;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+				busy_count++;
+			}
+
+			job();
+
+			{
+				std::lock_guard<std::mutex> lock(jobs_mutex);
+				busy_count--;
+			}
+			idle_cv.notify_all();
+		}
+	}
+}
\ No newline at end of file
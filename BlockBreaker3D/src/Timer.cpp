@@ -0,0 +1,143 @@
+#include "Engine.h"
+#include <algorithm>
+
+// Sleep until this close to the deadline, then spin the rest, OS sleeps overshoot by up to a scheduler tick
+#define TIMER_SPIN_THRESHOLD SDL_MS_TO_NS(2)
+
+namespace BB3D
+{
+	void Timer::Start()
+	{
+		current_frame = SDL_GetTicksNS();
+		last_frame = current_frame;
+		elapsed_time = 0.0f;
+		tick_accumulator = 0;
+		next_deadline = current_frame + target_frame_time;
+	}
+
+	void Timer::SetTargetRate(Uint32 target_fps)
+	{
+		target_frame_time = target_fps ? SDL_NS_PER_SECOND / target_fps : 0;
+		next_deadline = SDL_GetTicksNS() + target_frame_time;
+	}
+
+	void Timer::SetTickRate(Uint32 tick_rate, Uint32 max_ticks)
+	{
+		if (!tick_rate || !max_ticks)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Invalid tick rate %u with %u max ticks, using 120Hz with 8 max ticks\n", tick_rate, max_ticks);
+			tick_rate = 120;
+			max_ticks = 8;
+		}
+
+		tick_time = SDL_NS_PER_SECOND / tick_rate;
+		max_ticks_per_frame = max_ticks;
+		tick_accumulator = 0;
+	}
+
+	void Timer::LimitFrame()
+	{
+		limiter_wait_time = 0;
+		if (!target_frame_time)
+			return;
+
+		Uint64 now = SDL_GetTicksNS();
+
+		// Overran the frame, restart the cadence from here instead of rushing the next frames to catch up
+		if (now > next_deadline)
+		{
+			missed_deadlines++;
+			next_deadline = now + target_frame_time;
+			return;
+		}
+
+		Uint64 remaining = next_deadline - now;
+		if (remaining > TIMER_SPIN_THRESHOLD)
+			SDL_DelayNS(remaining - TIMER_SPIN_THRESHOLD);
+
+		while (SDL_GetTicksNS() < next_deadline)
+			SDL_CPUPauseInstruction();
+
+		limiter_wait_time = SDL_GetTicksNS() - now;
+
+		// Stepping from the deadline rather than from now keeps the rate from drifting
+		next_deadline += target_frame_time;
+	}
+
+	void Timer::Tick()
+	{
+		last_frame = current_frame;
+		current_frame = SDL_GetTicksNS();
+
+		Uint64 frame_time = current_frame - last_frame;
+		elapsed_time = static_cast<float>(frame_time) / static_cast<float>(SDL_NS_PER_SECOND);
+
+		// After a hitch the simulation slows down for a moment rather than trying to catch up all at once
+		tick_accumulator += frame_time;
+		if (tick_accumulator > tick_time * max_ticks_per_frame)
+			tick_accumulator = tick_time * max_ticks_per_frame;
+
+		frame_times[frame_times_head] = frame_time;
+		frame_times_head = (frame_times_head + 1) % FRAME_STATS_WINDOW;
+		if (frame_times_count < FRAME_STATS_WINDOW)
+			frame_times_count++;
+	}
+
+	bool Timer::ConsumeTick()
+	{
+		if (tick_accumulator < tick_time)
+			return false;
+
+		tick_accumulator -= tick_time;
+		return true;
+	}
+
+	float Timer::GetTickDelta()
+	{
+		return static_cast<float>(tick_time) / static_cast<float>(SDL_NS_PER_SECOND);
+	}
+
+	float Timer::GetTickAlpha()
+	{
+		return static_cast<float>(tick_accumulator) / static_cast<float>(tick_time);
+	}
+
+	// Last frame without the limiter's or the swapchain's wait, what the frame actually cost
+	float Timer::GetFrameCostMs()
+	{
+		Uint64 frame_time = current_frame - last_frame;
+		Uint64 wait_time = limiter_wait_time + present_wait_time;
+		Uint64 frame_cost = frame_time > wait_time ? frame_time - wait_time : 0;
+		return static_cast<float>(frame_cost) / static_cast<float>(SDL_NS_PER_MS);
+	}
+
+	FrameStats Timer::GetFrameStats()
+	{
+		FrameStats frame_stats = {};
+		frame_stats.missed_deadlines = missed_deadlines;
+		if (!frame_times_count)
+			return frame_stats;
+
+		std::array<Uint64, FRAME_STATS_WINDOW> sorted_times;
+		std::copy(frame_times.begin(), frame_times.begin() + frame_times_count, sorted_times.begin());
+
+		Uint64 total_time = 0;
+		Uint64 max_time = 0;
+		for (Uint32 i = 0; i < frame_times_count; i++)
+		{
+			total_time += sorted_times[i];
+			max_time = std::max(max_time, sorted_times[i]);
+		}
+
+		// Only the 99th percentile needs to land in place, no full sort
+		Uint32 p99_idx = (frame_times_count * 99 + 99) / 100 - 1;
+		std::nth_element(sorted_times.begin(), sorted_times.begin() + p99_idx, sorted_times.begin() + frame_times_count);
+
+		const float NS_TO_MS = 1.0f / static_cast<float>(SDL_NS_PER_MS);
+		frame_stats.avg_ms = static_cast<float>(total_time) / frame_times_count * NS_TO_MS;
+		frame_stats.p99_ms = static_cast<float>(sorted_times[p99_idx]) * NS_TO_MS;
+		frame_stats.max_ms = static_cast<float>(max_time) * NS_TO_MS;
+
+		return frame_stats;
+	}
+}
\ No newline at end of file
@@ -1,9 +1,22 @@
 #include "Engine.h"
 
-#define UI_QUAD_LIMIT_300 57600 // 300 quads * 6 vertices = 1800 vertices | 1800 vertices * 32 bytes = 57600
+#define UI_QUAD_LIMIT_300 36000 // 300 quads * 6 vertices = 1800 vertices | 1800 vertices * 20 bytes = 36000
 
 namespace BB3D
 {
+	// R in the lowest byte so UBYTE4_NORM reads it back as RGBA
+	static Uint32 PackColor(const glm::vec4& color)
+	{
+		Uint32 packed_color = 0;
+		for (int channel = 0; channel < 4; channel++)
+		{
+			float unorm_channel = SDL_clamp(color[channel], 0.0f, 1.0f);
+			packed_color |= static_cast<Uint32>(unorm_channel * 255.0f + 0.5f) << (channel * 8);
+		}
+
+		return packed_color;
+	}
+
 	SDL_GPUBuffer* CreateUILayerBuffer(SDL_GPUDevice* device)
 	{
 		SDL_GPUBuffer* new_ui_buff = {};
@@ -16,22 +29,133 @@ namespace BB3D
 		return new_ui_buff;
 	}
 
-	void UI::PushTextToUIBuff(SDL_GPUDevice* device, SDL_GPUBuffer* ui_buff, UI_TextField text_field, FontAtlas& atlas, Resolution screen_res)
+	void UI::Init(SDL_GPUDevice* device)
+	{
+		SDL_GPUTransferBufferCreateInfo ui_transfer_create_info = {};
+		ui_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+		ui_transfer_create_info.size = UI_QUAD_LIMIT_300;
+		staging_buff = SDL_CreateGPUTransferBuffer(device, &ui_transfer_create_info);
+		if (!staging_buff)
+		{
+			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to create UI staging buffer: %s\n", SDL_GetError());
+			std::abort();
+		}
+	}
+
+	void UI::BeginFrame(Uint32 scene_id, std::vector<UI_TextField>& text_fields)
+	{
+		// A different scene owns the UI buffer now, every field of it needs a fresh slot
+		if (scene_id != cached_scene_id)
+		{
+			cached_scene_id = scene_id;
+			cache_end = 0;
+			for (UI_TextField& text_field : text_fields)
+			{
+				text_field.is_dirty = true;
+				text_field.cache_capacity = 0;
+				text_field.is_full_logged = false;
+			}
+		}
+
+		frame_offset = cache_end;
+	}
+
+	void UI::UpdateTextCache(SDL_GPUDevice* device, std::vector<UI_TextField>& text_fields, FontAtlas& atlas, Resolution screen_res)
 	{
+		for (UI_TextField& text_field : text_fields)
+		{
+			if (text_field.is_dirty)
+				PushTextToUIBuff(device, text_field, atlas, screen_res);
+		}
+
+		frame_offset = cache_end;
+	}
+
+	UIVertex* UI::StageVertices(SDL_GPUDevice* device, unsigned int buff_offset, size_t vert_count)
+	{
+		unsigned int stage_size = sizeof(UIVertex) * vert_count;
+		if (buff_offset + stage_size > UI_QUAD_LIMIT_300 || staging_offset + stage_size > UI_QUAD_LIMIT_300)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "UI layer is full, dropping %zu vertices\n", vert_count);
+			return nullptr;
+		}
+
+		// Cycling hands back a fresh region if the GPU is still reading the last one, so there is no fence wait here
+		if (!staging_ptr)
+		{
+			staging_ptr = static_cast<Uint8*>(SDL_MapGPUTransferBuffer(device, staging_buff, true));
+			if (!staging_ptr)
+			{
+				SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to map UI staging buffer: %s\n", SDL_GetError());
+				std::abort();
+			}
+		}
+
+		UIVertex* staged_verts = reinterpret_cast<UIVertex*>(staging_ptr + staging_offset);
+		pending_uploads.push_back({ staging_offset, buff_offset, stage_size });
+		staging_offset += stage_size;
+
+		return staged_verts;
+	}
+
+	void UI::PushTextToUIBuff(SDL_GPUDevice* device, UI_TextField& text_field, FontAtlas& atlas, Resolution screen_res)
+	{
+		BB3D_PROFILE_FUNCTION();
+
+		// Grow into a new slot at the end of the cache, the old slot is reclaimed on the next scene change
+		if (text_field.cache_capacity < text_field.text.size())
+		{
+			// Both slots have to fit before anything moves, otherwise the field keeps its old slot and stays dirty
+			unsigned int old_slot_size = sizeof(UIVertex) * 6 * text_field.cache_capacity;
+			unsigned int new_slot_size = sizeof(UIVertex) * 6 * text_field.text.size();
+			if (cache_end + new_slot_size > UI_QUAD_LIMIT_300 || staging_offset + old_slot_size + new_slot_size > UI_QUAD_LIMIT_300)
+			{
+				// Retried every frame while dirty, but only worth saying once
+				if (!text_field.is_full_logged)
+					SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "UI layer is full, cannot grow text field to %zu glyphs\n", text_field.text.size());
+				text_field.is_full_logged = true;
+				return;
+			}
+
+			// The old slot is still inside the drawn range, blank it so its glyphs do not linger under the new ones
+			if (old_slot_size)
+			{
+				UIVertex* old_verts = StageVertices(device, text_field.cache_offset, 6 * text_field.cache_capacity);
+				std::memset(old_verts, 0, old_slot_size);
+			}
+
+			text_field.cache_offset = cache_end;
+			text_field.cache_capacity = text_field.text.size();
+			cache_end += new_slot_size;
+		}
+
+		UIVertex* dst_vert = StageVertices(device, text_field.cache_offset, 6 * text_field.cache_capacity);
+		if (!dst_vert)
+			return;
+
+		text_field.is_dirty = false;
+
+		// Hidden fields and unused capacity collapse into zero area triangles, so the whole cache stays one draw
+		UIVertex* dst_end = dst_vert + 6 * text_field.cache_capacity;
+		if (!text_field.is_visible)
+		{
+			std::memset(dst_vert, 0, sizeof(UIVertex) * 6 * text_field.cache_capacity);
+			return;
+		}
+
 		const float pixel_to_virt_y = 9.0f/static_cast<float>(screen_res.h);
 		const float pixel_to_virt_x = 16.0f/static_cast<float>(screen_res.w);
 
 		// UI Vertices
-		// X, Y, U, V, R, G, B, A
-		std::vector<Vertex> vertices;
-		vertices.reserve(6 * text_field.text.size());
+		// X, Y, U, V, RGBA8
+		Uint32 packed_color = PackColor(text_field.color);
 		unsigned int text_advance = 0;
 
 		// TODO | need to investigate further, 0.4 is the needed offset to have text quads centered at the top left corner. Not entirely sure why
 		float baseline = text_field.pos.y;
 
 		// For each char, add a quad with the correct precomputed UV's
-		for (char& c : text_field.text)
+		for (const char& c : text_field.text)
 		{ 
 			Glyph c_props = atlas.glyph_metadata[c];
 
@@ -54,129 +178,118 @@ namespace BB3D
 			float u_row = (offset % 16) * (1.0f / 16.0f);
 			
 
-			vertices.push_back({ final_x + w, final_y,															// tr 0
-								 u_row + 0.0625f, v_column,
-								 text_field.color[0], text_field.color[1], text_field.color[2], text_field.color[3]
-			});
-			vertices.push_back({ final_x + w, final_y + h,														// br 1
-								 u_row + 0.0625f, v_column + 0.0625f,
-								 text_field.color[0], text_field.color[1], text_field.color[2], text_field.color[3]
-			});
-			vertices.push_back({ final_x, final_y,																// tl 3
-								 u_row, v_column,
-								 text_field.color[0], text_field.color[1], text_field.color[2], text_field.color[3]
-			});										
-			vertices.push_back({ final_x + w, final_y + h,														// br 1
-								 u_row + 0.0625f, v_column + 0.0625f,
-								 text_field.color[0], text_field.color[1], text_field.color[2], text_field.color[3]
-			});
-			vertices.push_back({ final_x, final_y + h,															// bl 2
-								 u_row, v_column + 0.0625f,
-								 text_field.color[0], text_field.color[1], text_field.color[2], text_field.color[3]
-			});
-			vertices.push_back({ final_x, final_y,																// tl 3
-								 u_row, v_column,
-								 text_field.color[0], text_field.color[1], text_field.color[2], text_field.color[3]
-			});
+			*dst_vert++ = { final_x + w, final_y, u_row + 0.0625f, v_column, packed_color };					// tr 0
+			*dst_vert++ = { final_x + w, final_y + h, u_row + 0.0625f, v_column + 0.0625f, packed_color };		// br 1
+			*dst_vert++ = { final_x, final_y, u_row, v_column, packed_color };									// tl 3
+			*dst_vert++ = { final_x + w, final_y + h, u_row + 0.0625f, v_column + 0.0625f, packed_color };		// br 1
+			*dst_vert++ = { final_x, final_y + h, u_row, v_column + 0.0625f, packed_color };					// bl 2
+			*dst_vert++ = { final_x, final_y, u_row, v_column, packed_color };									// tl 3
 
 			text_advance += c_props.advance;
 		}
 
-		SDL_GPUTransferBufferCreateInfo ui_transfer_create_info = {};
-		ui_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-		ui_transfer_create_info.size = sizeof(Vertex) * vertices.size();
-		SDL_GPUTransferBuffer* ui_trans_buff = SDL_CreateGPUTransferBuffer(device, &ui_transfer_create_info);
-
-		void* ui_trans_ptr = SDL_MapGPUTransferBuffer(device, ui_trans_buff, false);
+		std::memset(dst_vert, 0, sizeof(UIVertex) * (dst_end - dst_vert));
+	}
 
-		std::memcpy(ui_trans_ptr, vertices.data(), sizeof(Vertex) * vertices.size());
+	void UI::PushElementToUIBuff(SDL_GPUDevice* device, const UI_Element& elem)
+	{
+		// UI Vertices
+		// X, Y, U, V, RGBA8
+		Uint32 packed_color = PackColor(elem.color);
+		UIVertex vertices[6] = {
+			{elem.pos.x + elem.width, elem.pos.y, 1.0, 0.0, packed_color},						// tr 0
+			{elem.pos.x + elem.width, elem.pos.y + elem.height, 1.0, 1.0, packed_color},		// br 1
+			{elem.pos.x, elem.pos.y, 0.0, 0.0, packed_color},									// tl 3
+			{elem.pos.x + elem.width, elem.pos.y + elem.height, 1.0, 1.0, packed_color},		// br 1
+			{elem.pos.x, elem.pos.y + elem.height, 0.0, 1.0, packed_color},						// bl 2
+			{elem.pos.x, elem.pos.y, 0.0, 0.0, packed_color},									// tl 3
+		};
 
-		SDL_UnmapGPUTransferBuffer(device, ui_trans_buff);
+		// Elements are transient and streamed after the retained text every frame
+		UIVertex* dst_vert = StageVertices(device, frame_offset, 6);
+		if (!dst_vert)
+			return;
 
-		SDL_GPUCommandBuffer* ui_copy_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
-		SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(ui_copy_cmd_buff);
+		std::memcpy(dst_vert, vertices, sizeof(vertices));
 
-		SDL_GPUTransferBufferLocation ui_trans_location = {};
-		ui_trans_location.transfer_buffer = ui_trans_buff;
-		ui_trans_location.offset = 0;
-		SDL_GPUBufferRegion ui_region = {};
-		ui_region.buffer = ui_buff;
-		ui_region.offset = frame_offset;
-		ui_region.size = sizeof(Vertex) * vertices.size();
+		frame_offset += sizeof(vertices);
+	}
 
-		SDL_UploadToGPUBuffer(copy_pass, &ui_trans_location, &ui_region, false);
+	Uint32 UI::EndFrame(SDL_GPUDevice* device, SDL_GPUCopyPass* copy_pass, SDL_GPUBuffer* ui_buff)
+	{
+		if (!staging_ptr)
+			return 0;
 
-		SDL_EndGPUCopyPass(copy_pass);
-		SDL_ReleaseGPUTransferBuffer(device, ui_trans_buff);
+		SDL_UnmapGPUTransferBuffer(device, staging_buff);
+		staging_ptr = nullptr;
 
-		SDL_GPUFence* upload_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(ui_copy_cmd_buff);
-		if (!upload_fence)
+		// Recorded into the frame's own command buffer, ahead of the render passes
+		// No cycling on the UI buffer since the retained text outside of these regions has to survive
+		Uint32 upload_size = 0;
+		for (UI_Upload& upload : pending_uploads)
 		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit copy command buffer to GPU and acquire fence: %s\n", SDL_GetError());
-			std::abort();
+			SDL_GPUTransferBufferLocation ui_trans_location = {};
+			ui_trans_location.transfer_buffer = staging_buff;
+			ui_trans_location.offset = upload.staging_offset;
+			SDL_GPUBufferRegion ui_region = {};
+			ui_region.buffer = ui_buff;
+			ui_region.offset = upload.buff_offset;
+			ui_region.size = upload.size;
+
+			SDL_UploadToGPUBuffer(copy_pass, &ui_trans_location, &ui_region, false);
+			upload_size += upload.size;
 		}
 
-		SDL_WaitForGPUFences(device, true, &upload_fence, 1);
-		SDL_ReleaseGPUFence(device, upload_fence);
-
-		frame_offset += sizeof(Vertex) * vertices.size();
+		return upload_size;
 	}
 
-	void UI::PushElementToUIBuff(SDL_GPUDevice* device, SDL_GPUBuffer* ui_buff, UI_Element elem)
+	void UI::FlushUIBuff(SDL_GPUDevice* device)
 	{
-		// UI Vertices
-		// X, Y, U, V, R, G, B, A
-		Vertex vertices[6] = {
-			{elem.pos.x + elem.width, elem.pos.y, 1.0, 0.0, elem.color[0], elem.color[1], elem.color[2], elem.color[3]},				// tr 0
-			{elem.pos.x + elem.width, elem.pos.y + elem.height, 1.0, 1.0, elem.color[0], elem.color[1], elem.color[2], elem.color[3]},  // br 1
-			{elem.pos.x, elem.pos.y, 0.0, 0.0, elem.color[0], elem.color[1], elem.color[2], elem.color[3]},								// tl 3
-			{elem.pos.x + elem.width, elem.pos.y + elem.height, 1.0, 1.0, elem.color[0], elem.color[1], elem.color[2], elem.color[3]},  // br 1
-			{elem.pos.x, elem.pos.y + elem.height, 0.0, 1.0, elem.color[0], elem.color[1], elem.color[2], elem.color[3]},				// bl 2
-			{elem.pos.x, elem.pos.y, 0.0, 0.0, elem.color[0], elem.color[1], elem.color[2], elem.color[3]},								// tl 3
-		};
-
-		SDL_GPUTransferBufferCreateInfo ui_transfer_create_info = {};
-		ui_transfer_create_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-		ui_transfer_create_info.size = sizeof(vertices);
-		SDL_GPUTransferBuffer* ui_trans_buff = SDL_CreateGPUTransferBuffer(device, &ui_transfer_create_info);
-
-		void* ui_trans_ptr = SDL_MapGPUTransferBuffer(device, ui_trans_buff, false);
-
-		std::memcpy(ui_trans_ptr, vertices, sizeof(vertices));
+		frame_offset = cache_end;
+		staging_offset = 0;
+		pending_uploads.clear();
+	}
 
-		SDL_UnmapGPUTransferBuffer(device, ui_trans_buff);
+	// ________________________________ UI_TextField ________________________________
+	void UI_TextField::SetText(const std::string& new_text)
+	{
+		if (text == new_text)
+			return;
 
-		SDL_GPUCommandBuffer* ui_copy_cmd_buff = SDL_AcquireGPUCommandBuffer(device);
-		SDL_GPUCopyPass* copy_pass = SDL_BeginGPUCopyPass(ui_copy_cmd_buff);
+		text = new_text;
+		is_dirty = true;
+	}
 
-		SDL_GPUTransferBufferLocation ui_trans_location = {};
-		ui_trans_location.transfer_buffer = ui_trans_buff;
-		ui_trans_location.offset = 0;
-		SDL_GPUBufferRegion ui_region = {};
-		ui_region.buffer = ui_buff;
-		ui_region.offset = frame_offset;
-		ui_region.size = sizeof(vertices);
+	void UI_TextField::SetPos(glm::vec2 new_pos)
+	{
+		if (pos == new_pos)
+			return;
 
-		SDL_UploadToGPUBuffer(copy_pass, &ui_trans_location, &ui_region, false);
+		pos = new_pos;
+		is_dirty = true;
+	}
 
-		SDL_EndGPUCopyPass(copy_pass);
-		SDL_ReleaseGPUTransferBuffer(device, ui_trans_buff);
+	void UI_TextField::SetColor(glm::vec4 new_color)
+	{
+		if (color == new_color)
+			return;
 
-		SDL_GPUFence* upload_fence = SDL_SubmitGPUCommandBufferAndAcquireFence(ui_copy_cmd_buff);
-		if(!upload_fence)
-		{
-			SDL_LogCritical(SDL_LOG_CATEGORY_ERROR, "Failed to submit copy command buffer to GPU and acquire fence: %s\n", SDL_GetError());
-			std::abort();
-		}
+		color = new_color;
+		is_dirty = true;
+	}
 
-		SDL_WaitForGPUFences(device, true, &upload_fence, 1);
-		SDL_ReleaseGPUFence(device, upload_fence);
+	void UI_TextField::SetVisible(bool new_is_visible)
+	{
+		if (is_visible == new_is_visible)
+			return;
 
-		frame_offset += sizeof(vertices);
+		is_visible = new_is_visible;
+		is_dirty = true;
 	}
 
-	void UI::FlushUIBuff(SDL_GPUDevice* device)
+	void UI::Release(SDL_GPUDevice* device)
 	{
-		frame_offset = 0;
+		SDL_ReleaseGPUTransferBuffer(device, staging_buff);
+		staging_buff = nullptr;
 	}
 }
\ No newline at end of file
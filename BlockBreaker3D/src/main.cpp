@@ -3,6 +3,7 @@
 int main(int argc, char** argv)
 {
 	BB3D::Engine engine;
+	engine.ParseArgs(argc, argv);
 	engine.Init();
 	engine.Run();
 	engine.Destroy();
@@ -0,0 +1,32 @@
+#version 450
+
+struct Instance {
+	mat4 model;
+	uint texture_layer; uint pad0; uint pad1; uint pad2;
+};
+
+layout(std430, set=0, binding = 0) readonly buffer InstanceBuffer {
+	Instance instances[];
+};
+
+layout(set=1, binding = 0)uniform UBO {
+	mat4 view_proj;
+	uint instance_base; uint pad3; uint pad4; uint pad5;
+};
+
+layout(location = 0) in vec3 a_pos;
+layout(location = 1) in vec2 a_normal_oct;
+layout(location = 2) in vec2 a_uv;
+
+layout(location = 0) out vec2 frag_uv;
+layout(location = 1) flat out uint frag_layer;
+
+void main()
+{
+	// first_instance is always 0 on the draw call, the batch offset comes in through the UBO
+	Instance inst = instances[instance_base + gl_InstanceIndex];
+
+	gl_Position = view_proj * inst.model * vec4(a_pos, 1.0);
+	frag_uv = a_uv;
+	frag_layer = inst.texture_layer;
+}
\ No newline at end of file
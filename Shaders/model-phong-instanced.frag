@@ -0,0 +1,107 @@
+#version 450
+
+// GLSL pads vec3 to 16 bytes per std140, caused a fun lighting bug
+layout(set=3, binding = 0)uniform UBO {
+	vec3 object_color_base; float pad0;						// 16 bytes
+	vec3 view_pos; float pad1;								// 16 bytes
+	mat4 view;												// 64 bytes
+	vec2 screen_size; float cluster_z_near; float cluster_z_far;	// 16 bytes
+	uvec4 grid_size;										// x | y | depth slices | max lights per cluster
+};
+
+struct Light {
+	vec4 position_radius;	// world space position | radius
+	vec4 color;
+};
+
+// Filled once per frame by the light cull compute pass
+layout(std430, set=2, binding = 1) readonly buffer LightBuffer {
+	Light lights[];
+};
+
+layout(std430, set=2, binding = 2) readonly buffer ClusterCountBuffer {
+	uint cluster_light_counts[];
+};
+
+layout(std430, set=2, binding = 3) readonly buffer ClusterIndexBuffer {
+	uint cluster_light_indices[];
+};
+
+layout(location = 0) in vec3 normal;
+layout(location = 1) in vec2 frag_uv;
+layout(location = 2) in vec3 frag_pos;
+layout(location = 3) flat in uint frag_layer;
+
+layout(location = 0) out vec4 final_color;
+
+layout(set=2, binding=0) uniform sampler2DArray tex_sampler;
+
+vec3 calc_point_light(Light light, vec3 albedo, vec3 normal, vec3 frag_pos, vec3 view_dir)
+{
+	const float AMBIENT_STRENGTH = 0.2;
+	const float SPECULAR_STRENGTH = 0.5;
+	const float CONSTANT = 1.0;
+	const float LINEAR = 0.07;
+	const float QUADRATIC = 0.017;
+
+	vec3 light_pos = light.position_radius.xyz;
+	vec3 light_dir = normalize(light_pos - frag_pos);
+
+	// diffuse -> specular -> attenuate
+	float diff = max(dot(normal, light_dir), 0.0);
+
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 32);
+
+	// Windowed so the light reaches exactly zero at its radius and the cluster bounds hold
+	float dist = length(light_pos - frag_pos);
+	float window = clamp(1.0 - pow(dist / light.position_radius.w, 4.0), 0.0, 1.0);
+	float attenuation = window * window / (CONSTANT + LINEAR * dist + QUADRATIC * (dist * dist));
+
+	// combine
+	vec3 ambient = AMBIENT_STRENGTH * albedo;
+	vec3 diffuse = diff * albedo * light.color.rgb;
+	vec3 specular = SPECULAR_STRENGTH * spec * light.color.rgb;
+
+	ambient *= attenuation;
+	diffuse *= attenuation;
+	specular *= attenuation;
+
+	return (ambient + diffuse + specular);
+}
+
+uint find_cluster()
+{
+	float view_depth = -(view * vec4(frag_pos, 1.0)).z;
+
+	uvec2 tile = uvec2(gl_FragCoord.xy / screen_size * vec2(grid_size.xy));
+	tile = min(tile, grid_size.xy - 1);
+
+	// Exponential slices, matching slice_depth in light-cull.comp
+	float slice_f = log(max(view_depth, cluster_z_near) / cluster_z_near) / log(cluster_z_far / cluster_z_near);
+	uint slice = min(uint(slice_f * float(grid_size.z)), grid_size.z - 1);
+
+	return tile.x + tile.y * grid_size.x + slice * grid_size.x * grid_size.y;
+}
+
+void main()
+{
+	vec3 view_dir = normalize(view_pos - frag_pos);
+	vec3 albedo = vec3(texture(tex_sampler, vec3(frag_uv, frag_layer)));
+
+	// Only the lights binned into this fragment's cluster
+	uint cluster_idx = find_cluster();
+	uint cluster_light_count = cluster_light_counts[cluster_idx];
+
+	vec3 result = vec3(0.0f);
+	for(uint i = 0; i < cluster_light_count; i++)
+	{
+		Light light = lights[cluster_light_indices[cluster_idx * grid_size.w + i]];
+		result += calc_point_light(light, albedo, normalize(normal), frag_pos, view_dir);
+	}
+
+	final_color = vec4(result, 1.0);
+	//final_color = vec4(normalize(normal) * 0.5 + 0.5, 1.0);
+	//final_color = vec4(normalize(frag_pos) * 0.5 + 0.5, 1.0);
+	//final_color = vec4(light_dir * 0.5 + 0.5, 1.0);
+}
\ No newline at end of file
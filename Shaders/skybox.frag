@@ -6,7 +6,14 @@ layout(location = 0) out vec4 final_color;
 
 layout(set=2, binding=0) uniform samplerCube cube_sampler;
 
+layout(set=3, binding = 0)uniform UBO {
+	uint channel_count;
+};
+
 void main()
 {
-	final_color = texture(cube_sampler, cubemap_frag);
+	vec4 texel = texture(cube_sampler, cubemap_frag);
+
+	// Single channel skyboxes only store red
+	final_color = channel_count == 1 ? vec4(texel.rrr, 1.0) : texel;
 }
\ No newline at end of file
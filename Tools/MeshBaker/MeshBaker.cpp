@@ -0,0 +1,274 @@
+#include "MeshFormat.h"
+#include "MeshOptimizer.h"
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+// FIFO size the ACMR report is measured against
+#define BAKED_MESH_ACMR_CACHE_SIZE 16
+// Overdraw clustering may give back up to 5% of the vertex cache gain
+#define BAKED_MESH_OVERDRAW_THRESHOLD 1.05f
+// Below this a LOD saves less than the draw it costs
+#define BAKED_MESH_LOD_MIN_TRIANGLES 32
+
+namespace BB3D
+{
+	struct BakedMesh
+	{
+		std::vector<MeshVertex> vertices;
+		std::vector<uint32_t> indices;
+		BakedMeshHeader header;
+	};
+
+	// Round to nearest even, overflow saturates to infinity and denormals flush to zero, UVs never need either
+	static uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		uint32_t sign = (bits >> 16) & 0x8000;
+		int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+		uint32_t mantissa = bits & 0x7FFFFF;
+
+		if (exponent <= 0)
+			return static_cast<uint16_t>(sign);
+		if (exponent >= 31)
+			return static_cast<uint16_t>(sign | 0x7C00);
+
+		uint32_t half = sign | static_cast<uint32_t>(exponent) << 10 | mantissa >> 13;
+		uint32_t round_bits = mantissa & 0x1FFF;
+		if (round_bits > 0x1000 || (round_bits == 0x1000 && (half & 0x1)))
+			half++;
+
+		return static_cast<uint16_t>(half);
+	}
+
+	static int16_t QuantizeSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	// Projects the unit normal onto an octahedron and unfolds it into the [-1, 1] square
+	static void EncodeOctNormal(float x, float y, float z, int16_t out_oct[2])
+	{
+		float length_l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+		if (length_l1 <= 0.0f)
+		{
+			out_oct[0] = 0;
+			out_oct[1] = 0;
+			return;
+		}
+
+		float oct_x = x / length_l1;
+		float oct_y = y / length_l1;
+		if (z < 0.0f)
+		{
+			float folded_x = (1.0f - std::fabs(oct_y)) * (oct_x >= 0.0f ? 1.0f : -1.0f);
+			float folded_y = (1.0f - std::fabs(oct_x)) * (oct_y >= 0.0f ? 1.0f : -1.0f);
+			oct_x = folded_x;
+			oct_y = folded_y;
+		}
+
+		out_oct[0] = QuantizeSnorm16(oct_x);
+		out_oct[1] = QuantizeSnorm16(oct_y);
+	}
+
+	static bool ImportMesh(const char* filepath, BakedMesh& baked_mesh)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(filepath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals);
+		if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mNumMeshes)
+		{
+			std::fprintf(stderr, "Failed to load model from %s: ASSIMP: %s\n", filepath, importer.GetErrorString());
+			return false;
+		}
+
+		aiMesh* loaded_mesh = scene->mMeshes[0];
+		baked_mesh.vertices.reserve(loaded_mesh->mNumVertices);
+		for (unsigned int i = 0; i < loaded_mesh->mNumVertices; i++)
+		{
+			aiVector3D uv = loaded_mesh->mTextureCoords[0] ? loaded_mesh->mTextureCoords[0][i] : aiVector3D{ 0.0f, 0.0f, 0.0f };
+
+			MeshVertex new_vert = {};
+			new_vert.position[0] = loaded_mesh->mVertices[i].x;
+			new_vert.position[1] = loaded_mesh->mVertices[i].y;
+			new_vert.position[2] = loaded_mesh->mVertices[i].z;
+			EncodeOctNormal(loaded_mesh->mNormals[i].x, loaded_mesh->mNormals[i].y, loaded_mesh->mNormals[i].z, new_vert.normal_oct);
+			new_vert.uv_half[0] = FloatToHalf(uv.x);
+			new_vert.uv_half[1] = FloatToHalf(uv.y);
+
+			baked_mesh.vertices.push_back(new_vert);
+		}
+
+		for (unsigned int i = 0; i < loaded_mesh->mNumFaces; i++)
+		{
+			aiFace face = loaded_mesh->mFaces[i];
+			for (unsigned int j = 0; j < face.mNumIndices; j++)
+				baked_mesh.indices.push_back(face.mIndices[j]);
+		}
+
+		return true;
+	}
+
+	static void ComputeBounds(BakedMesh& baked_mesh)
+	{
+		BakedMeshHeader& header = baked_mesh.header;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			header.aabb_min[axis] = FLT_MAX;
+			header.aabb_max[axis] = -FLT_MAX;
+		}
+
+		for (const MeshVertex& vert : baked_mesh.vertices)
+		{
+			const float* vert_pos = vert.position;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				header.aabb_min[axis] = std::min(header.aabb_min[axis], vert_pos[axis]);
+				header.aabb_max[axis] = std::max(header.aabb_max[axis], vert_pos[axis]);
+			}
+		}
+
+		// The sphere is centered on the AABB and grown to the farthest vertex
+		for (int axis = 0; axis < 3; axis++)
+			header.sphere_center[axis] = (header.aabb_min[axis] + header.aabb_max[axis]) * 0.5f;
+
+		header.sphere_radius = 0.0f;
+		for (const MeshVertex& vert : baked_mesh.vertices)
+		{
+			const float* vert_pos = vert.position;
+			float dx = vert_pos[0] - header.sphere_center[0];
+			float dy = vert_pos[1] - header.sphere_center[1];
+			float dz = vert_pos[2] - header.sphere_center[2];
+			header.sphere_radius = std::max(header.sphere_radius, std::sqrt(dx * dx + dy * dy + dz * dz));
+		}
+	}
+
+	// Each LOD aims for half the triangles of the one before, all of them reordered and packed into one index buffer
+	static void BuildLods(BakedMesh& baked_mesh, float& out_acmr_before, float& out_acmr_after)
+	{
+		uint32_t vertex_count = static_cast<uint32_t>(baked_mesh.vertices.size());
+		std::vector<std::vector<uint32_t>> lod_indices = { baked_mesh.indices };
+		std::vector<float> lod_errors = { 0.0f };
+
+		while (lod_indices.size() < BAKED_MESH_MAX_LODS)
+		{
+			size_t target_index_count = lod_indices.back().size() / 6 * 3;
+			if (target_index_count / 3 < BAKED_MESH_LOD_MIN_TRIANGLES)
+				break;
+
+			// Always from the full mesh, so errors do not compound from level to level
+			float lod_error = 0.0f;
+			std::vector<uint32_t> lod = SimplifyMesh(baked_mesh.indices, baked_mesh.vertices, target_index_count, lod_error);
+
+			// Stalled on locked seams and borders, another level would barely draw less
+			if (lod.size() > lod_indices.back().size() * 3 / 4)
+				break;
+
+			lod_indices.push_back(std::move(lod));
+			lod_errors.push_back(lod_error);
+		}
+
+		out_acmr_before = ComputeACMR(lod_indices[0], vertex_count, BAKED_MESH_ACMR_CACHE_SIZE);
+
+		BakedMeshHeader& header = baked_mesh.header;
+		header.lod_count = static_cast<uint32_t>(lod_indices.size());
+		baked_mesh.indices.clear();
+		for (size_t i = 0; i < lod_indices.size(); i++)
+		{
+			OptimizeVertexCache(lod_indices[i], vertex_count);
+			OptimizeOverdraw(lod_indices[i], baked_mesh.vertices, BAKED_MESH_OVERDRAW_THRESHOLD);
+
+			header.lods[i].first_index = static_cast<uint32_t>(baked_mesh.indices.size());
+			header.lods[i].index_count = static_cast<uint32_t>(lod_indices[i].size());
+			header.lods[i].error = lod_errors[i];
+			baked_mesh.indices.insert(baked_mesh.indices.end(), lod_indices[i].begin(), lod_indices[i].end());
+		}
+
+		// Renumbering does not change which vertices hit the cache, so the ACMR can be taken before it
+		out_acmr_after = ComputeACMR(lod_indices[0], vertex_count, BAKED_MESH_ACMR_CACHE_SIZE);
+
+		// LOD 0 goes first so its fetches walk forward, the coarser levels only use a subset of its vertices
+		OptimizeVertexFetch(baked_mesh.indices, baked_mesh.vertices);
+	}
+
+	static bool WriteBakedMesh(const char* filepath, BakedMesh& baked_mesh)
+	{
+		BakedMeshHeader& header = baked_mesh.header;
+		header.magic = BAKED_MESH_MAGIC;
+		header.version = BAKED_MESH_VERSION;
+		header.vertex_count = static_cast<uint32_t>(baked_mesh.vertices.size());
+		header.index_count = static_cast<uint32_t>(baked_mesh.indices.size());
+		header.vertex_stride = sizeof(MeshVertex);
+		// 16 bit indices whenever they can address every vertex
+		header.index_size = header.vertex_count > UINT16_MAX + 1 ? sizeof(uint32_t) : sizeof(uint16_t);
+
+		//  Header|Vertices|Indices
+		// |----->|------->|
+		header.vertex_offset = sizeof(BakedMeshHeader);
+		header.index_offset = header.vertex_offset + header.vertex_count * header.vertex_stride;
+
+		std::ofstream out_file(filepath, std::ios::binary | std::ios::trunc);
+		if (!out_file)
+		{
+			std::fprintf(stderr, "Failed to open %s for writing\n", filepath);
+			return false;
+		}
+
+		out_file.write(reinterpret_cast<const char*>(&header), sizeof(BakedMeshHeader));
+		out_file.write(reinterpret_cast<const char*>(baked_mesh.vertices.data()), baked_mesh.vertices.size() * sizeof(MeshVertex));
+		if (header.index_size == sizeof(uint32_t))
+		{
+			out_file.write(reinterpret_cast<const char*>(baked_mesh.indices.data()), baked_mesh.indices.size() * sizeof(uint32_t));
+		}
+		else
+		{
+			std::vector<uint16_t> narrow_indices(baked_mesh.indices.begin(), baked_mesh.indices.end());
+			out_file.write(reinterpret_cast<const char*>(narrow_indices.data()), narrow_indices.size() * sizeof(uint16_t));
+		}
+
+		if (!out_file)
+		{
+			std::fprintf(stderr, "Failed to write %s\n", filepath);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "Usage: MeshBaker <input.obj> <output%s>\n", BAKED_MESH_EXTENSION);
+		return 1;
+	}
+
+	BB3D::BakedMesh baked_mesh = {};
+	if (!BB3D::ImportMesh(argv[1], baked_mesh))
+		return 1;
+
+	float acmr_before = 0.0f;
+	float acmr_after = 0.0f;
+	BB3D::BuildLods(baked_mesh, acmr_before, acmr_after);
+
+	BB3D::ComputeBounds(baked_mesh);
+
+	if (!BB3D::WriteBakedMesh(argv[2], baked_mesh))
+		return 1;
+
+	std::printf("Baked %s -> %s (%u vertices, %u indices, %u bit), ACMR %.3f -> %.3f\n", argv[1], argv[2],
+		baked_mesh.header.vertex_count, baked_mesh.header.index_count, baked_mesh.header.index_size * 8, acmr_before, acmr_after);
+	for (uint32_t i = 0; i < baked_mesh.header.lod_count; i++)
+		std::printf("  LOD %u: %u triangles, error %.4f\n", i, baked_mesh.header.lods[i].index_count / 3, baked_mesh.header.lods[i].error);
+	return 0;
+}
\ No newline at end of file
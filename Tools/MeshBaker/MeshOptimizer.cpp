@@ -0,0 +1,312 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+
+// Forsyth's scoring constants, tuned for a 32 entry LRU
+#define VCACHE_SIZE 32
+#define VCACHE_DECAY_POWER 1.5f
+#define VCACHE_LAST_TRI_SCORE 0.75f
+#define VCACHE_VALENCE_SCALE 2.0f
+#define VCACHE_VALENCE_POWER 0.5f
+
+// Clusters are measured against a small FIFO, the conservative end of what hardware actually has
+#define OVERDRAW_CACHE_SIZE 16
+
+namespace BB3D
+{
+	// ________________________________ Vertex Cache ________________________________
+	float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size)
+	{
+		if (indices.size() < 3)
+			return 0.0f;
+
+		// A vertex is still cached while fewer than cache_size misses happened since it was inserted
+		std::vector<uint32_t> insert_time(vertex_count, 0);
+		uint32_t timestamp = cache_size + 1;
+		uint32_t misses = 0;
+
+		for (uint32_t vert_idx : indices)
+		{
+			if (timestamp - insert_time[vert_idx] > cache_size)
+			{
+				insert_time[vert_idx] = timestamp++;
+				misses++;
+			}
+		}
+
+		return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	}
+
+	static float ScoreVertex(int cache_pos, uint32_t live_triangles)
+	{
+		// Nothing left to draw with this vertex, it should fall out of the cache
+		if (!live_triangles)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cache_pos >= 0)
+		{
+			// The last triangle's vertices get a flat score so the order does not zig zag between strips
+			if (cache_pos < 3)
+				score = VCACHE_LAST_TRI_SCORE;
+			else
+				score = std::pow(1.0f - static_cast<float>(cache_pos - 3) / static_cast<float>(VCACHE_SIZE - 3), VCACHE_DECAY_POWER);
+		}
+
+		// Favour vertices with few triangles left so lone triangles get finished off early
+		score += VCACHE_VALENCE_SCALE * std::pow(static_cast<float>(live_triangles), -VCACHE_VALENCE_POWER);
+		return score;
+	}
+
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count)
+	{
+		size_t tri_count = indices.size() / 3;
+		if (!tri_count)
+			return;
+
+		// Vertex -> triangle adjacency, the live triangles of a vertex are kept at the front of its run
+		std::vector<uint32_t> live_count(vertex_count, 0);
+		for (uint32_t vert_idx : indices)
+			live_count[vert_idx]++;
+
+		std::vector<uint32_t> adjacency_offset(vertex_count + 1, 0);
+		for (uint32_t i = 0; i < vertex_count; i++)
+			adjacency_offset[i + 1] = adjacency_offset[i] + live_count[i];
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> adjacency_cursor(adjacency_offset.begin(), adjacency_offset.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+			adjacency[adjacency_cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+		std::vector<int> cache_pos(vertex_count, -1);
+		std::vector<float> vert_score(vertex_count);
+		for (uint32_t i = 0; i < vertex_count; i++)
+			vert_score[i] = ScoreVertex(-1, live_count[i]);
+
+		std::vector<float> tri_score(tri_count);
+		std::vector<uint8_t> is_emitted(tri_count, 0);
+		for (size_t i = 0; i < tri_count; i++)
+			tri_score[i] = vert_score[indices[i * 3]] + vert_score[indices[i * 3 + 1]] + vert_score[indices[i * 3 + 2]];
+
+		// Only the very first pick scans every triangle
+		size_t best_tri = std::max_element(tri_score.begin(), tri_score.end()) - tri_score.begin();
+		size_t fallback_cursor = 0;
+
+		// Room for a full cache plus the 3 vertices pushed in front before the tail is dropped
+		uint32_t cache[VCACHE_SIZE + 3];
+		uint32_t cache_count = 0;
+
+		std::vector<uint32_t> ordered_indices;
+		ordered_indices.reserve(indices.size());
+
+		for (size_t emitted = 0; emitted < tri_count; emitted++)
+		{
+			const uint32_t* tri_verts = &indices[best_tri * 3];
+			ordered_indices.insert(ordered_indices.end(), tri_verts, tri_verts + 3);
+			is_emitted[best_tri] = 1;
+
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t vert_idx = tri_verts[corner];
+				uint32_t* live_begin = &adjacency[adjacency_offset[vert_idx]];
+				uint32_t* live_end = live_begin + live_count[vert_idx];
+				std::iter_swap(std::find(live_begin, live_end, static_cast<uint32_t>(best_tri)), live_end - 1);
+				live_count[vert_idx]--;
+			}
+
+			// The emitted triangle moves to the front, everything else shifts back
+			uint32_t new_cache[VCACHE_SIZE + 3];
+			uint32_t new_count = 0;
+			for (int corner = 0; corner < 3; corner++)
+				if (std::find(new_cache, new_cache + new_count, tri_verts[corner]) == new_cache + new_count)
+					new_cache[new_count++] = tri_verts[corner];
+			for (uint32_t i = 0; i < cache_count; i++)
+				if (std::find(new_cache, new_cache + new_count, cache[i]) == new_cache + new_count)
+					new_cache[new_count++] = cache[i];
+
+			// Rescore everything that moved, including what just fell off the end
+			for (uint32_t i = 0; i < new_count; i++)
+			{
+				uint32_t vert_idx = new_cache[i];
+				cache_pos[vert_idx] = i < VCACHE_SIZE ? static_cast<int>(i) : -1;
+
+				float new_score = ScoreVertex(cache_pos[vert_idx], live_count[vert_idx]);
+				float score_delta = new_score - vert_score[vert_idx];
+				vert_score[vert_idx] = new_score;
+
+				const uint32_t* live_begin = &adjacency[adjacency_offset[vert_idx]];
+				for (uint32_t j = 0; j < live_count[vert_idx]; j++)
+					tri_score[live_begin[j]] += score_delta;
+			}
+
+			cache_count = std::min<uint32_t>(new_count, VCACHE_SIZE);
+			std::copy(new_cache, new_cache + cache_count, cache);
+
+			// Next triangle comes from whatever the cache touches
+			float best_score = -FLT_MAX;
+			bool has_best = false;
+			for (uint32_t i = 0; i < cache_count; i++)
+			{
+				uint32_t vert_idx = cache[i];
+				const uint32_t* live_begin = &adjacency[adjacency_offset[vert_idx]];
+				for (uint32_t j = 0; j < live_count[vert_idx]; j++)
+				{
+					uint32_t tri_idx = live_begin[j];
+					if (tri_score[tri_idx] > best_score)
+					{
+						best_score = tri_score[tri_idx];
+						best_tri = tri_idx;
+						has_best = true;
+					}
+				}
+			}
+
+			// Dead end, restart from the first triangle not drawn yet, keeps the whole pass linear
+			if (!has_best)
+			{
+				while (fallback_cursor < tri_count && is_emitted[fallback_cursor])
+					fallback_cursor++;
+				best_tri = fallback_cursor;
+			}
+		}
+
+		indices.swap(ordered_indices);
+	}
+
+	// ________________________________ Overdraw ________________________________
+	struct TriangleCluster
+	{
+		uint32_t first_tri;
+		uint32_t tri_count;
+		float sort_key;
+	};
+
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float acmr_threshold)
+	{
+		size_t tri_count = indices.size() / 3;
+		if (!tri_count)
+			return;
+
+		uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+		float target_acmr = ComputeACMR(indices, vertex_count, OVERDRAW_CACHE_SIZE) * acmr_threshold;
+
+		// A cluster starts with a cold cache and closes once its own miss ratio is back under the target
+		// Every cluster but the tail ends under the target, the tail never got there and is folded into the one before it
+		std::vector<TriangleCluster> clusters;
+		std::vector<uint32_t> insert_time(vertex_count, 0);
+		uint32_t timestamp = OVERDRAW_CACHE_SIZE + 1;
+		uint32_t cluster_misses = 0;
+		TriangleCluster current_cluster = {};
+
+		for (size_t i = 0; i < tri_count; i++)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t vert_idx = indices[i * 3 + corner];
+				if (timestamp - insert_time[vert_idx] > OVERDRAW_CACHE_SIZE)
+				{
+					insert_time[vert_idx] = timestamp++;
+					cluster_misses++;
+				}
+			}
+			current_cluster.tri_count++;
+
+			if (static_cast<float>(cluster_misses) <= target_acmr * current_cluster.tri_count)
+			{
+				clusters.push_back(current_cluster);
+				current_cluster = { static_cast<uint32_t>(i + 1), 0, 0.0f };
+				cluster_misses = 0;
+
+				// Flush, the next cluster may end up drawn anywhere
+				timestamp += OVERDRAW_CACHE_SIZE + 1;
+			}
+		}
+		// Still contiguous with the previous cluster, so it keeps that cache instead of paying for a cold start of its own
+		if (current_cluster.tri_count)
+		{
+			if (clusters.empty())
+				clusters.push_back(current_cluster);
+			else
+				clusters.back().tri_count += current_cluster.tri_count;
+		}
+
+		if (clusters.size() < 2)
+			return;
+
+		// Area weighted centroids, the cross product length is twice the triangle area
+		auto accumulate_triangle = [&](size_t tri_idx, float out_centroid[3], float out_normal[3], float& out_area)
+		{
+			const float* p0 = vertices[indices[tri_idx * 3]].position;
+			const float* p1 = vertices[indices[tri_idx * 3 + 1]].position;
+			const float* p2 = vertices[indices[tri_idx * 3 + 2]].position;
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float cross[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float area = std::sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				out_centroid[axis] += (p0[axis] + p1[axis] + p2[axis]) / 3.0f * area;
+				out_normal[axis] += cross[axis];
+			}
+			out_area += area;
+		};
+
+		float mesh_centroid[3] = {};
+		float mesh_normal[3] = {};
+		float mesh_area = 0.0f;
+		for (size_t i = 0; i < tri_count; i++)
+			accumulate_triangle(i, mesh_centroid, mesh_normal, mesh_area);
+		for (int axis = 0; axis < 3; axis++)
+			mesh_centroid[axis] /= mesh_area > 0.0f ? mesh_area : 1.0f;
+
+		// Clusters facing away from the middle of the mesh are the likely occluders, so they go first
+		for (TriangleCluster& cluster : clusters)
+		{
+			float cluster_centroid[3] = {};
+			float cluster_normal[3] = {};
+			float cluster_area = 0.0f;
+			for (uint32_t i = cluster.first_tri; i < cluster.first_tri + cluster.tri_count; i++)
+				accumulate_triangle(i, cluster_centroid, cluster_normal, cluster_area);
+
+			float normal_length = std::sqrt(cluster_normal[0] * cluster_normal[0] + cluster_normal[1] * cluster_normal[1] + cluster_normal[2] * cluster_normal[2]);
+			if (cluster_area <= 0.0f || normal_length <= 0.0f)
+				continue;
+
+			cluster.sort_key = 0.0f;
+			for (int axis = 0; axis < 3; axis++)
+				cluster.sort_key += (cluster_centroid[axis] / cluster_area - mesh_centroid[axis]) * cluster_normal[axis] / normal_length;
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b) { return a.sort_key > b.sort_key; });
+
+		std::vector<uint32_t> sorted_indices;
+		sorted_indices.reserve(indices.size());
+		for (const TriangleCluster& cluster : clusters)
+			sorted_indices.insert(sorted_indices.end(), indices.begin() + cluster.first_tri * 3, indices.begin() + (cluster.first_tri + cluster.tri_count) * 3);
+
+		indices.swap(sorted_indices);
+	}
+
+	// ________________________________ Vertex Fetch ________________________________
+	void OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<MeshVertex>& vertices)
+	{
+		std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+		std::vector<MeshVertex> ordered_vertices;
+		ordered_vertices.reserve(vertices.size());
+
+		for (uint32_t& vert_idx : indices)
+		{
+			if (remap[vert_idx] == UINT32_MAX)
+			{
+				remap[vert_idx] = static_cast<uint32_t>(ordered_vertices.size());
+				ordered_vertices.push_back(vertices[vert_idx]);
+			}
+			vert_idx = remap[vert_idx];
+		}
+
+		vertices.swap(ordered_vertices);
+	}
+}
\ No newline at end of file
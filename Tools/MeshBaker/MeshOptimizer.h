@@ -0,0 +1,28 @@
+#pragma once
+
+#include "MeshFormat.h"
+#include <cstddef>
+#include <vector>
+
+// Import time LOD generation and reordering for the post transform cache, overdraw and vertex fetch
+// Reordering runs in this order, each pass keeps most of what the previous one gained
+namespace BB3D
+{
+	// Quadric error edge collapse down to target_index_count, or as close as the locked seams and borders allow
+	// Only references existing vertices, out_error is the largest area weighted RMS plane distance of any merged quadric
+	// That is an average over the folded planes in object units, an estimate of the deviation rather than a bound on it
+	std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, size_t target_index_count, float& out_error);
+
+	// Average cache miss ratio, transformed vertices per triangle through a FIFO cache of cache_size entries
+	float ComputeACMR(const std::vector<uint32_t>& indices, uint32_t vertex_count, uint32_t cache_size);
+
+	// Tom Forsyth's linear speed greedy triangle ordering against an LRU cache model
+	void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertex_count);
+
+	// Splits the cache ordered triangles into clusters and draws the outward facing ones first
+	// acmr_threshold bounds how much of the cache gain each cluster boundary is allowed to give back
+	void OptimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, float acmr_threshold);
+
+	// Renumbers vertices in order of first use so fetches walk the vertex buffer forward, unreferenced vertices are dropped
+	void OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<MeshVertex>& vertices);
+}
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "MeshOptimizer.h"
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <algorithm>
+
+namespace BB3D
+{
+	// Symmetric 4x4 error matrix, the area weighted sum of squared distances to every plane folded into it
+	struct Quadric
+	{
+		double a2, ab, ac, ad;
+		double b2, bc, bd;
+		double c2, cd;
+		double d2;
+		double weight;
+
+	public:
+		void AddPlane(double a, double b, double c, double d, double w)
+		{
+			a2 += a * a * w; ab += a * b * w; ac += a * c * w; ad += a * d * w;
+			b2 += b * b * w; bc += b * c * w; bd += b * d * w;
+			c2 += c * c * w; cd += c * d * w;
+			d2 += d * d * w;
+			weight += w;
+		}
+
+		void Add(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd;
+			d2 += other.d2;
+			weight += other.weight;
+		}
+
+		double Evaluate(const float pos[3]) const
+		{
+			double x = pos[0], y = pos[1], z = pos[2];
+			return a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x +
+				b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y +
+				c2 * z * z + 2.0 * cd * z +
+				d2;
+		}
+	};
+
+	struct EdgeCollapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+		double distance_sq; // cost over the merged weight, a mean squared distance
+	};
+
+	static void TriangleNormal(const float* p0, const float* p1, const float* p2, float out_normal[3])
+	{
+		float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+		float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+		out_normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		out_normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		out_normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	// Seam and border vertices never move, otherwise UVs tear and open edges pull inwards
+	static std::vector<uint8_t> FindLockedVertices(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices)
+	{
+		std::vector<uint8_t> is_locked(vertices.size(), 0);
+
+		// Seams, one position split into several vertices by its UVs or normals
+		std::vector<uint32_t> by_position(vertices.size());
+		std::iota(by_position.begin(), by_position.end(), 0);
+		std::sort(by_position.begin(), by_position.end(), [&](uint32_t a, uint32_t b)
+			{
+				return std::memcmp(vertices[a].position, vertices[b].position, sizeof(MeshVertex::position)) < 0;
+			}
+		);
+		for (size_t i = 1; i < by_position.size(); i++)
+		{
+			if (!std::memcmp(vertices[by_position[i - 1]].position, vertices[by_position[i]].position, sizeof(MeshVertex::position)))
+			{
+				is_locked[by_position[i - 1]] = 1;
+				is_locked[by_position[i]] = 1;
+			}
+		}
+
+		// Borders and non manifold edges, anything not shared by exactly two triangles
+		std::vector<uint64_t> edges;
+		edges.reserve(indices.size());
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint64_t a = indices[i + corner];
+				uint64_t b = indices[i + (corner + 1) % 3];
+				edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+
+		for (size_t run_start = 0; run_start < edges.size();)
+		{
+			size_t run_end = run_start;
+			while (run_end < edges.size() && edges[run_end] == edges[run_start])
+				run_end++;
+
+			if (run_end - run_start != 2)
+			{
+				is_locked[edges[run_start] >> 32] = 1;
+				is_locked[edges[run_start] & 0xFFFFFFFF] = 1;
+			}
+			run_start = run_end;
+		}
+
+		return is_locked;
+	}
+
+	std::vector<uint32_t> SimplifyMesh(const std::vector<uint32_t>& indices, const std::vector<MeshVertex>& vertices, size_t target_index_count, float& out_error)
+	{
+		uint32_t vertex_count = static_cast<uint32_t>(vertices.size());
+		std::vector<uint32_t> lod_indices(indices);
+		std::vector<uint8_t> is_locked = FindLockedVertices(indices, vertices);
+		out_error = 0.0f;
+
+		// Area weighted so large faces hold their shape, normalized by the weight to read as a distance
+		std::vector<Quadric> quadrics(vertex_count, Quadric{});
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const float* p0 = vertices[indices[i]].position;
+			float normal[3];
+			TriangleNormal(p0, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position, normal);
+
+			float normal_length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (normal_length <= 0.0f)
+				continue;
+
+			double a = normal[0] / normal_length, b = normal[1] / normal_length, c = normal[2] / normal_length;
+			double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+			for (int corner = 0; corner < 3; corner++)
+				quadrics[indices[i + corner]].AddPlane(a, b, c, d, normal_length * 0.5f);
+		}
+
+		std::vector<uint32_t> remap(vertex_count);
+		std::vector<uint8_t> is_touched(vertex_count);
+		std::vector<uint32_t> adjacency_offset(vertex_count + 1);
+		std::vector<uint32_t> adjacency;
+		std::vector<EdgeCollapse> collapses;
+
+		// Each pass collapses the cheapest independent edges, a vertex moves at most once per pass
+		while (lod_indices.size() > target_index_count)
+		{
+			// Vertex -> triangle adjacency for the orientation checks
+			std::fill(adjacency_offset.begin(), adjacency_offset.end(), 0);
+			for (uint32_t vert_idx : lod_indices)
+				adjacency_offset[vert_idx + 1]++;
+			for (uint32_t i = 0; i < vertex_count; i++)
+				adjacency_offset[i + 1] += adjacency_offset[i];
+
+			adjacency.resize(lod_indices.size());
+			std::vector<uint32_t> adjacency_cursor(adjacency_offset.begin(), adjacency_offset.end() - 1);
+			for (size_t i = 0; i < lod_indices.size(); i++)
+				adjacency[adjacency_cursor[lod_indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+			// Half edge collapses only, the removed vertex lands on its neighbour so every LOD shares one vertex buffer
+			collapses.clear();
+			for (size_t i = 0; i < lod_indices.size(); i += 3)
+			{
+				for (int corner = 0; corner < 3; corner++)
+				{
+					uint32_t a = lod_indices[i + corner];
+					uint32_t b = lod_indices[i + (corner + 1) % 3];
+
+					Quadric edge_quadric = quadrics[a];
+					edge_quadric.Add(quadrics[b]);
+					double weight = edge_quadric.weight > 0.0 ? edge_quadric.weight : 1.0;
+					if (!is_locked[a])
+					{
+						double cost = std::max(edge_quadric.Evaluate(vertices[b].position), 0.0);
+						collapses.push_back({ a, b, cost, cost / weight });
+					}
+					if (!is_locked[b])
+					{
+						double cost = std::max(edge_quadric.Evaluate(vertices[a].position), 0.0);
+						collapses.push_back({ b, a, cost, cost / weight });
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(), [](const EdgeCollapse& a, const EdgeCollapse& b) { return a.cost < b.cost; });
+
+			std::iota(remap.begin(), remap.end(), 0);
+			std::fill(is_touched.begin(), is_touched.end(), 0);
+			size_t index_count = lod_indices.size();
+			size_t applied_count = 0;
+
+			for (const EdgeCollapse& collapse : collapses)
+			{
+				if (index_count <= target_index_count)
+					break;
+				if (is_touched[collapse.from] || is_touched[collapse.to])
+					continue;
+
+				// Every triangle that keeps its area has to keep facing the same way
+				bool is_valid = true;
+				uint32_t removed_triangles = 0;
+				for (uint32_t j = adjacency_offset[collapse.from]; j < adjacency_offset[collapse.from + 1] && is_valid; j++)
+				{
+					const uint32_t* tri_verts = &lod_indices[adjacency[j] * 3];
+					if (tri_verts[0] == collapse.to || tri_verts[1] == collapse.to || tri_verts[2] == collapse.to)
+					{
+						removed_triangles++;
+						continue;
+					}
+
+					const float* old_pos[3];
+					const float* new_pos[3];
+					for (int corner = 0; corner < 3; corner++)
+					{
+						old_pos[corner] = vertices[tri_verts[corner]].position;
+						new_pos[corner] = vertices[tri_verts[corner] == collapse.from ? collapse.to : tri_verts[corner]].position;
+					}
+
+					float old_normal[3], new_normal[3];
+					TriangleNormal(old_pos[0], old_pos[1], old_pos[2], old_normal);
+					TriangleNormal(new_pos[0], new_pos[1], new_pos[2], new_normal);
+					is_valid = old_normal[0] * new_normal[0] + old_normal[1] * new_normal[1] + old_normal[2] * new_normal[2] > 0.0f;
+				}
+
+				if (!is_valid || !removed_triangles)
+					continue;
+
+				remap[collapse.from] = collapse.to;
+				quadrics[collapse.to].Add(quadrics[collapse.from]);
+				out_error = std::max(out_error, static_cast<float>(std::sqrt(collapse.distance_sq)));
+
+				// The whole one ring is frozen, its triangles were validated against positions that must not change this pass
+				for (uint32_t j = adjacency_offset[collapse.from]; j < adjacency_offset[collapse.from + 1]; j++)
+					for (int corner = 0; corner < 3; corner++)
+						is_touched[lod_indices[adjacency[j] * 3 + corner]] = 1;
+
+				index_count -= removed_triangles * 3;
+				applied_count++;
+			}
+
+			// Everything left is locked or would fold over
+			if (!applied_count)
+				break;
+
+			size_t write_idx = 0;
+			for (size_t i = 0; i < lod_indices.size(); i += 3)
+			{
+				uint32_t a = remap[lod_indices[i]];
+				uint32_t b = remap[lod_indices[i + 1]];
+				uint32_t c = remap[lod_indices[i + 2]];
+				if (a == b || b == c || a == c)
+					continue;
+
+				lod_indices[write_idx++] = a;
+				lod_indices[write_idx++] = b;
+				lod_indices[write_idx++] = c;
+			}
+			lod_indices.resize(write_idx);
+		}
+
+		return lod_indices;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "SceneFormat.h"
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <fstream>
+#include "nlohmann/json.hpp"
+
+namespace BB3D
+{
+	struct BakedScene
+	{
+		BakedSceneHeader header = {};
+		std::vector<BakedSceneEntity> entities;
+		std::vector<BakedSceneText> texts;
+		std::string string_data;
+	};
+
+	static void ReadFloats(const nlohmann::json& values, float* out_values, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			out_values[i] = values.at(i).get<float>();
+	}
+
+	// Same schema Scene::Scene reads, every key is required so a typo fails the build instead of the level
+	static bool ImportScene(const char* filepath, BakedScene& baked_scene)
+	{
+		std::ifstream scene_f(filepath);
+		if (!scene_f)
+		{
+			std::fprintf(stderr, "Failed to open %s\n", filepath);
+			return false;
+		}
+
+		try
+		{
+			nlohmann::json scene_data = nlohmann::json::parse(scene_f);
+
+			for (const nlohmann::json& loaded_entity : scene_data.at("entities"))
+			{
+				BakedSceneEntity baked_entity = {};
+				baked_entity.mesh = loaded_entity.at("mesh").get<uint8_t>();
+				baked_entity.texture = loaded_entity.at("texture").get<uint8_t>();
+				baked_entity.flags |= loaded_entity.at("is_shaded").get<bool>() ? BAKED_ENTITY_SHADED : 0;
+				baked_entity.flags |= loaded_entity.at("is_active").get<bool>() ? BAKED_ENTITY_ACTIVE : 0;
+				ReadFloats(loaded_entity.at("position"), baked_entity.position, 3);
+				ReadFloats(loaded_entity.at("rotation"), baked_entity.rotation, 3);
+				ReadFloats(loaded_entity.at("scale"), baked_entity.scale, 3);
+				baked_scene.entities.push_back(baked_entity);
+			}
+
+			// Scenes without UI may leave the text fields out
+			if (scene_data.contains("textfields"))
+			{
+				for (const nlohmann::json& loaded_text : scene_data.at("textfields"))
+				{
+					std::string text = loaded_text.at("text").get<std::string>();
+
+					BakedSceneText baked_text = {};
+					baked_text.text_offset = static_cast<uint32_t>(baked_scene.string_data.size());
+					baked_text.text_length = static_cast<uint32_t>(text.size());
+					ReadFloats(loaded_text.at("position"), baked_text.position, 2);
+					ReadFloats(loaded_text.at("color"), baked_text.color, 4);
+					baked_text.is_visible = loaded_text.at("is_visible").get<bool>() ? 1 : 0;
+					baked_scene.texts.push_back(baked_text);
+					baked_scene.string_data += text;
+				}
+			}
+		}
+		catch (const nlohmann::json::exception& json_error)
+		{
+			std::fprintf(stderr, "Failed to read scene %s: %s\n", filepath, json_error.what());
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool WriteBakedScene(const char* filepath, BakedScene& baked_scene)
+	{
+		BakedSceneHeader& header = baked_scene.header;
+		header.magic = BAKED_SCENE_MAGIC;
+		header.version = BAKED_SCENE_VERSION;
+		header.entity_count = static_cast<uint32_t>(baked_scene.entities.size());
+		header.text_count = static_cast<uint32_t>(baked_scene.texts.size());
+		header.string_size = static_cast<uint32_t>(baked_scene.string_data.size());
+
+		//  Header|Entities|Texts|Strings
+		// |----->|------->|---->|
+		header.entity_offset = sizeof(BakedSceneHeader);
+		header.text_offset = header.entity_offset + header.entity_count * sizeof(BakedSceneEntity);
+		header.string_offset = header.text_offset + header.text_count * sizeof(BakedSceneText);
+
+		std::ofstream out_file(filepath, std::ios::binary | std::ios::trunc);
+		if (!out_file)
+		{
+			std::fprintf(stderr, "Failed to open %s for writing\n", filepath);
+			return false;
+		}
+
+		out_file.write(reinterpret_cast<const char*>(&header), sizeof(BakedSceneHeader));
+		out_file.write(reinterpret_cast<const char*>(baked_scene.entities.data()), baked_scene.entities.size() * sizeof(BakedSceneEntity));
+		out_file.write(reinterpret_cast<const char*>(baked_scene.texts.data()), baked_scene.texts.size() * sizeof(BakedSceneText));
+		out_file.write(baked_scene.string_data.data(), baked_scene.string_data.size());
+
+		if (!out_file)
+		{
+			std::fprintf(stderr, "Failed to write %s\n", filepath);
+			return false;
+		}
+
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		std::fprintf(stderr, "Usage: SceneBaker <input.json> <output%s>\n", BAKED_SCENE_EXTENSION);
+		return 1;
+	}
+
+	BB3D::BakedScene baked_scene = {};
+	if (!BB3D::ImportScene(argv[1], baked_scene))
+		return 1;
+
+	if (!BB3D::WriteBakedScene(argv[2], baked_scene))
+		return 1;
+
+	std::printf("Baked %s -> %s (%u entities, %u text fields)\n", argv[1], argv[2], baked_scene.header.entity_count, baked_scene.header.text_count);
+	return 0;
+}
\ No newline at end of file
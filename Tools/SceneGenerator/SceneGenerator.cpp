@@ -0,0 +1,249 @@
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+
+// Mirrors MeshType and TextureType in Engine.h, the tools do not pull in SDL
+#define MESH_ICO 0x0
+#define MESH_QUAD 0x1
+#define MESH_SPHERE 0x2
+#define MESH_PADDLE 0x3
+#define MESH_BLOCK 0x4
+#define TEXTURE_GEM03 0x2
+#define TEXTURE_PADDLE01 0x4
+#define TEXTURE_GEM13 0x5
+#define TEXTURE_METAL21 0x6
+#define TEXTURE_BLOCK1 0x7
+#define TEXTURE_BLOCK_COUNT 5
+
+// Same block pitch as the hard coded map in GameScene
+#define BLOCK_SPACING_X 2.0f
+#define BLOCK_SPACING_Z 1.0f
+#define LIGHT_HEIGHT 3.0f
+#define TEXT_ROWS 16
+#define TEXT_COLUMNS 4
+
+namespace BB3D
+{
+	enum BlockLayout
+	{
+		LAYOUT_GRID,
+		LAYOUT_RANDOM
+	};
+
+	struct GeneratorOptions
+	{
+		BlockLayout layout = LAYOUT_GRID;
+		uint32_t block_count = 1000;
+		uint32_t light_count = 4;
+		uint32_t text_count = 1;
+		uint64_t seed = 1;
+		const char* output_path = nullptr;
+	};
+
+	// Own PCG32 and float conversion so a seed gives the same scene on every platform and standard library
+	struct SceneRandom
+	{
+		uint64_t state;
+
+		uint32_t Next()
+		{
+			uint64_t old_state = state;
+			state = old_state * 6364136223846793005ULL + 1442695040888963407ULL;
+			uint32_t xor_shifted = static_cast<uint32_t>(((old_state >> 18u) ^ old_state) >> 27u);
+			uint32_t rot = static_cast<uint32_t>(old_state >> 59u);
+			return (xor_shifted >> rot) | (xor_shifted << ((32 - rot) & 31));
+		}
+
+		float Range(float min_value, float max_value)
+		{
+			return min_value + (max_value - min_value) * static_cast<float>(Next() >> 8) * (1.0f / 16777216.0f);
+		}
+	};
+
+	static bool ParseCount(const char* text, uint32_t& out_count)
+	{
+		char* text_end = nullptr;
+		unsigned long value = std::strtoul(text, &text_end, 10);
+		if (text_end == text || *text_end != '\0')
+			return false;
+
+		out_count = static_cast<uint32_t>(value);
+		return true;
+	}
+
+	static bool ParseGeneratorOptions(int argc, char* argv[], GeneratorOptions& options)
+	{
+		int arg_idx = 1;
+		for (; arg_idx < argc && argv[arg_idx][0] == '-'; arg_idx++)
+		{
+			bool has_value = arg_idx + 1 < argc;
+			if (std::strcmp(argv[arg_idx], "--layout") == 0 && has_value)
+			{
+				const char* layout_name = argv[++arg_idx];
+				if (std::strcmp(layout_name, "grid") == 0)
+					options.layout = LAYOUT_GRID;
+				else if (std::strcmp(layout_name, "random") == 0)
+					options.layout = LAYOUT_RANDOM;
+				else
+				{
+					std::fprintf(stderr, "Unknown layout %s\n", layout_name);
+					return false;
+				}
+			}
+			else if (std::strcmp(argv[arg_idx], "--blocks") == 0 && has_value)
+			{
+				if (!ParseCount(argv[++arg_idx], options.block_count))
+					return false;
+			}
+			else if (std::strcmp(argv[arg_idx], "--lights") == 0 && has_value)
+			{
+				if (!ParseCount(argv[++arg_idx], options.light_count))
+					return false;
+			}
+			else if (std::strcmp(argv[arg_idx], "--texts") == 0 && has_value)
+			{
+				if (!ParseCount(argv[++arg_idx], options.text_count))
+					return false;
+			}
+			else if (std::strcmp(argv[arg_idx], "--seed") == 0 && has_value)
+			{
+				options.seed = std::strtoull(argv[++arg_idx], nullptr, 10);
+			}
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", argv[arg_idx]);
+				return false;
+			}
+		}
+
+		if (argc - arg_idx != 1)
+			return false;
+
+		options.output_path = argv[arg_idx];
+		return true;
+	}
+
+	static void WriteEntity(std::FILE* scene_f, bool& is_first, int mesh, int texture, float px, float py, float pz, float rot_y, float sx, float sy, float sz, bool is_shaded)
+	{
+		std::fprintf(
+			scene_f,
+			"%s    {\n"
+			"      \"mesh\": %d,\n"
+			"      \"texture\": %d,\n"
+			"      \"position\": [ %.3f, %.3f, %.3f ],\n"
+			"      \"rotation\": [ 0.0, %.3f, 0.0 ],\n"
+			"      \"scale\": [ %.3f, %.3f, %.3f ],\n"
+			"      \"is_shaded\": %s,\n"
+			"      \"is_active\": true\n"
+			"    }",
+			is_first ? "" : ",\n",
+			mesh, texture, px, py, pz, rot_y, sx, sy, sz, is_shaded ? "true" : "false"
+		);
+		is_first = false;
+	}
+
+	static bool WriteScene(const GeneratorOptions& options)
+	{
+		std::FILE* scene_f = std::fopen(options.output_path, "wb");
+		if (!scene_f)
+		{
+			std::fprintf(stderr, "Failed to open %s for writing\n", options.output_path);
+			return false;
+		}
+
+		SceneRandom scene_random = { options.seed * 2 + 1 };
+
+		// Near square footprint, twice as many rows as columns since blocks are half as deep as they are wide
+		uint32_t grid_columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(options.block_count) * 0.5f)));
+		grid_columns = grid_columns ? grid_columns : 1;
+		uint32_t grid_rows = (options.block_count + grid_columns - 1) / grid_columns;
+		float half_width = 0.5f * grid_columns * BLOCK_SPACING_X;
+		float half_depth = 0.5f * grid_rows * BLOCK_SPACING_Z;
+
+		std::fprintf(scene_f, "{\n  \"entities\": [\n");
+		bool is_first = true;
+
+		// Paddle, floor and ball keep the slots GameScene expects, so a generated file also loads as a level
+		WriteEntity(scene_f, is_first, MESH_PADDLE, TEXTURE_PADDLE01, 0.0f, 0.0f, half_depth + 1.5f, 0.0f, 0.5f, 0.5f, 0.5f, true);
+		WriteEntity(scene_f, is_first, MESH_QUAD, TEXTURE_METAL21, 0.0f, -2.0f, 0.0f, 0.0f, half_width + 2.0f, 1.0f, half_depth + 2.0f, true);
+		WriteEntity(scene_f, is_first, MESH_SPHERE, TEXTURE_GEM13, 0.0f, 0.0f, half_depth + 0.5f, 0.0f, 0.5f, 0.5f, 0.5f, true);
+
+		// Unshaded entities are what the engine gathers as lights
+		for (uint32_t i = 0; i < options.light_count; i++)
+		{
+			float light_x = scene_random.Range(-half_width, half_width);
+			float light_z = scene_random.Range(-half_depth, half_depth);
+			WriteEntity(scene_f, is_first, MESH_ICO, TEXTURE_GEM03, light_x, LIGHT_HEIGHT, light_z, 0.0f, 0.5f, 0.5f, 0.5f, false);
+		}
+
+		for (uint32_t i = 0; i < options.block_count; i++)
+		{
+			int block_texture = TEXTURE_BLOCK1 + static_cast<int>(scene_random.Next() % TEXTURE_BLOCK_COUNT);
+			if (options.layout == LAYOUT_GRID)
+			{
+				float block_x = -half_width + BLOCK_SPACING_X * (0.5f + i % grid_columns);
+				float block_z = -half_depth + BLOCK_SPACING_Z * (0.5f + i / grid_columns);
+				WriteEntity(scene_f, is_first, MESH_BLOCK, block_texture, block_x, 0.0f, block_z, 0.0f, 0.5f, 0.5f, 0.5f, true);
+			}
+			else
+			{
+				// Same footprint as the grid, free to overlap and turned so the sort and instancing see some variety
+				float block_x = scene_random.Range(-half_width, half_width);
+				float block_y = scene_random.Range(0.0f, 2.0f);
+				float block_z = scene_random.Range(-half_depth, half_depth);
+				float block_rot = scene_random.Range(0.0f, 360.0f);
+				WriteEntity(scene_f, is_first, MESH_BLOCK, block_texture, block_x, block_y, block_z, block_rot, 0.5f, 0.5f, 0.5f, true);
+			}
+		}
+
+		std::fprintf(scene_f, "\n  ],\n\n  \"textfields\": [\n");
+
+		// Columns of rows across the 16x9 UI space, past TEXT_ROWS * TEXT_COLUMNS the fields start to overlap
+		for (uint32_t i = 0; i < options.text_count; i++)
+		{
+			float text_x = 0.25f + 4.0f * ((i / TEXT_ROWS) % TEXT_COLUMNS);
+			float text_y = 0.625f + 0.5f * (i % TEXT_ROWS);
+			std::fprintf(
+				scene_f,
+				"%s    {\n"
+				"      \"text\": \"Stress %05u\",\n"
+				"      \"position\": [ %.3f, %.3f ],\n"
+				"      \"color\": [ 0.96, 0.96, 0.96, 1.0 ],\n"
+				"      \"is_visible\": true\n"
+				"    }",
+				i ? ",\n" : "",
+				i, text_x, text_y
+			);
+		}
+
+		std::fprintf(scene_f, "\n  ]\n}");
+
+		bool is_written = std::ferror(scene_f) == 0;
+		if (std::fclose(scene_f) != 0 || !is_written)
+		{
+			std::fprintf(stderr, "Failed to write %s\n", options.output_path);
+			return false;
+		}
+
+		std::printf("%s: %u blocks (%s), %u lights, %u text fields\n", options.output_path, options.block_count,
+			options.layout == LAYOUT_GRID ? "grid" : "random", options.light_count, options.text_count);
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BB3D::GeneratorOptions options = {};
+	if (!BB3D::ParseGeneratorOptions(argc, argv, options))
+	{
+		std::fprintf(stderr, "Usage: SceneGenerator [--layout grid|random] [--blocks N] [--lights M] [--texts K] [--seed S] <output.json>\n");
+		return 1;
+	}
+
+	if (!BB3D::WriteScene(options))
+		return 1;
+
+	return 0;
+}
\ No newline at end of file
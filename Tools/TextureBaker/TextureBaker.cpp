@@ -0,0 +1,419 @@
+#include "TextureFormat.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+// Texels whose channels differ by no more than this still count as grey
+#define GREY_TOLERANCE 2
+
+namespace BB3D
+{
+	struct SourceImage
+	{
+		uint32_t width;
+		uint32_t height;
+		std::vector<uint8_t> texels; // RGBA8
+	};
+
+	struct BakeOptions
+	{
+		BakedTextureType type = BAKED_TEXTURE_2D;
+		bool use_block_compression = false;
+		bool allow_single_channel = false;
+		const char* output_path = nullptr;
+		std::vector<const char*> input_paths;
+	};
+
+	static bool ParseBakeOptions(int argc, char* argv[], BakeOptions& options)
+	{
+		int arg_idx = 1;
+		for (; arg_idx < argc && argv[arg_idx][0] == '-'; arg_idx++)
+		{
+			if (std::strcmp(argv[arg_idx], "--bc") == 0)
+				options.use_block_compression = true;
+			else if (std::strcmp(argv[arg_idx], "--allow-r8") == 0)
+				options.allow_single_channel = true;
+			else
+			{
+				std::fprintf(stderr, "Unknown option %s\n", argv[arg_idx]);
+				return false;
+			}
+		}
+
+		if (argc - arg_idx < 3)
+			return false;
+
+		const char* type_name = argv[arg_idx++];
+		if (std::strcmp(type_name, "2d") == 0)
+			options.type = BAKED_TEXTURE_2D;
+		else if (std::strcmp(type_name, "array") == 0)
+			options.type = BAKED_TEXTURE_2D_ARRAY;
+		else if (std::strcmp(type_name, "cube") == 0)
+			options.type = BAKED_TEXTURE_CUBE;
+		else
+		{
+			std::fprintf(stderr, "Unknown texture type %s\n", type_name);
+			return false;
+		}
+
+		options.output_path = argv[arg_idx++];
+		for (; arg_idx < argc; arg_idx++)
+			options.input_paths.push_back(argv[arg_idx]);
+
+		if (options.type == BAKED_TEXTURE_2D && options.input_paths.size() != 1)
+		{
+			std::fprintf(stderr, "A 2d texture takes exactly one input\n");
+			return false;
+		}
+
+		// Faces in +X -X +Y -Y +Z -Z order, same as SDL_GPUCubeMapFace
+		if (options.type == BAKED_TEXTURE_CUBE && options.input_paths.size() != 6)
+		{
+			std::fprintf(stderr, "A cube texture takes exactly six inputs\n");
+			return false;
+		}
+
+		return true;
+	}
+
+	static bool LoadSourceImages(const BakeOptions& options, std::vector<SourceImage>& images)
+	{
+		// Cubemap faces are sampled by direction and stay as authored, everything else is flipped for the UV convention
+		stbi_set_flip_vertically_on_load(options.type != BAKED_TEXTURE_CUBE);
+
+		for (const char* input_path : options.input_paths)
+		{
+			int width, height, channels;
+			stbi_uc* image_data = stbi_load(input_path, &width, &height, &channels, 4);
+			if (!image_data)
+			{
+				std::fprintf(stderr, "Failed to load %s: %s\n", input_path, stbi_failure_reason());
+				return false;
+			}
+
+			SourceImage new_image = {};
+			new_image.width = static_cast<uint32_t>(width);
+			new_image.height = static_cast<uint32_t>(height);
+			new_image.texels.assign(image_data, image_data + width * height * 4);
+			stbi_image_free(image_data);
+
+			if (!images.empty() && (new_image.width != images[0].width || new_image.height != images[0].height))
+			{
+				std::fprintf(stderr, "%s is %ux%u, expected %ux%u like the other layers\n", input_path, new_image.width, new_image.height, images[0].width, images[0].height);
+				return false;
+			}
+
+			images.push_back(std::move(new_image));
+		}
+
+		return true;
+	}
+
+	static bool IsSingleChannel(const std::vector<SourceImage>& images)
+	{
+		for (const SourceImage& image : images)
+		{
+			for (size_t i = 0; i < image.texels.size(); i += 4)
+			{
+				const uint8_t* texel = &image.texels[i];
+				int spread = std::max({ texel[0], texel[1], texel[2] }) - std::min({ texel[0], texel[1], texel[2] });
+				if (spread > GREY_TOLERANCE || texel[3] != 255)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	// 2x2 box filter, the odd row or column on the edge is folded into its neighbour
+	static SourceImage Downsample(const SourceImage& src)
+	{
+		SourceImage dst = {};
+		dst.width = std::max(src.width / 2, 1u);
+		dst.height = std::max(src.height / 2, 1u);
+		dst.texels.resize(dst.width * dst.height * 4);
+
+		for (uint32_t y = 0; y < dst.height; y++)
+		{
+			for (uint32_t x = 0; x < dst.width; x++)
+			{
+				uint32_t x0 = std::min(x * 2, src.width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, src.width - 1);
+				uint32_t y0 = std::min(y * 2, src.height - 1);
+				uint32_t y1 = std::min(y * 2 + 1, src.height - 1);
+
+				for (int c = 0; c < 4; c++)
+				{
+					uint32_t sum = src.texels[(y0 * src.width + x0) * 4 + c] + src.texels[(y0 * src.width + x1) * 4 + c]
+						+ src.texels[(y1 * src.width + x0) * 4 + c] + src.texels[(y1 * src.width + x1) * 4 + c];
+					dst.texels[(y * dst.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+
+		return dst;
+	}
+
+	static void FetchBlock(const SourceImage& image, uint32_t block_x, uint32_t block_y, uint8_t block[16][4])
+	{
+		// Partial blocks on the edge repeat the last row and column
+		for (uint32_t y = 0; y < 4; y++)
+		{
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				uint32_t src_x = std::min(block_x * 4 + x, image.width - 1);
+				uint32_t src_y = std::min(block_y * 4 + y, image.height - 1);
+				std::memcpy(block[y * 4 + x], &image.texels[(src_y * image.width + src_x) * 4], 4);
+			}
+		}
+	}
+
+	static uint16_t PackRGB565(const int rgb[3])
+	{
+		return static_cast<uint16_t>(((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 | ((rgb[2] * 31 + 127) / 255));
+	}
+
+	static void UnpackRGB565(uint16_t packed, int rgb[3])
+	{
+		rgb[0] = ((packed >> 11) & 0x1F) * 255 / 31;
+		rgb[1] = ((packed >> 5) & 0x3F) * 255 / 63;
+		rgb[2] = (packed & 0x1F) * 255 / 31;
+	}
+
+	// Bounding box endpoints inset by 1/16 of the range, good enough for diffuse maps this size
+	static void EncodeBC1Block(const uint8_t block[16][4], uint8_t* out_block)
+	{
+		int min_rgb[3] = { 255, 255, 255 };
+		int max_rgb[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				min_rgb[c] = std::min(min_rgb[c], static_cast<int>(block[i][c]));
+				max_rgb[c] = std::max(max_rgb[c], static_cast<int>(block[i][c]));
+			}
+		}
+
+		for (int c = 0; c < 3; c++)
+		{
+			int inset = (max_rgb[c] - min_rgb[c]) / 16;
+			min_rgb[c] += inset;
+			max_rgb[c] -= inset;
+		}
+
+		uint16_t color0 = PackRGB565(max_rgb);
+		uint16_t color1 = PackRGB565(min_rgb);
+
+		// color0 > color1 selects the opaque 4 colour mode
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		int palette[4][3];
+		UnpackRGB565(color0, palette[0]);
+		UnpackRGB565(color1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int best_idx = 0;
+				int best_dist = INT32_MAX;
+				for (int p = 0; p < 4; p++)
+				{
+					int dr = block[i][0] - palette[p][0];
+					int dg = block[i][1] - palette[p][1];
+					int db = block[i][2] - palette[p][2];
+					int dist = dr * dr + dg * dg + db * db;
+					if (dist < best_dist)
+					{
+						best_dist = dist;
+						best_idx = p;
+					}
+				}
+				indices |= static_cast<uint32_t>(best_idx) << (i * 2);
+			}
+		}
+
+		std::memcpy(out_block, &color0, 2);
+		std::memcpy(out_block + 2, &color1, 2);
+		std::memcpy(out_block + 4, &indices, 4);
+	}
+
+	static void EncodeBC4Block(const uint8_t block[16][4], uint8_t* out_block)
+	{
+		int red0 = 0;
+		int red1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			red0 = std::max(red0, static_cast<int>(block[i][0]));
+			red1 = std::min(red1, static_cast<int>(block[i][0]));
+		}
+
+		// red0 > red1 selects the 8 value mode
+		int palette[8] = { red0, red1 };
+		for (int p = 1; p < 7; p++)
+			palette[p + 1] = ((7 - p) * red0 + p * red1) / 7;
+
+		uint64_t indices = 0;
+		if (red0 != red1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int best_idx = 0;
+				int best_dist = INT32_MAX;
+				for (int p = 0; p < 8; p++)
+				{
+					int dist = std::abs(block[i][0] - palette[p]);
+					if (dist < best_dist)
+					{
+						best_dist = dist;
+						best_idx = p;
+					}
+				}
+				indices |= static_cast<uint64_t>(best_idx) << (i * 3);
+			}
+		}
+
+		out_block[0] = static_cast<uint8_t>(red0);
+		out_block[1] = static_cast<uint8_t>(red1);
+		for (int i = 0; i < 6; i++)
+			out_block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+	}
+
+	static void EncodeLevel(const SourceImage& image, BakedTextureFormat format, std::vector<uint8_t>& out_data)
+	{
+		size_t level_start = out_data.size();
+		out_data.resize(level_start + GetBakedTextureSize(format, image.width, image.height));
+		uint8_t* level_data = out_data.data() + level_start;
+
+		if (format == BAKED_FORMAT_RGBA8)
+		{
+			std::memcpy(level_data, image.texels.data(), image.texels.size());
+			return;
+		}
+
+		if (format == BAKED_FORMAT_R8)
+		{
+			for (size_t i = 0; i < image.width * image.height; i++)
+				level_data[i] = image.texels[i * 4];
+			return;
+		}
+
+		uint32_t blocks_x = (image.width + 3) / 4;
+		uint32_t blocks_y = (image.height + 3) / 4;
+		for (uint32_t block_y = 0; block_y < blocks_y; block_y++)
+		{
+			for (uint32_t block_x = 0; block_x < blocks_x; block_x++)
+			{
+				uint8_t block[16][4];
+				FetchBlock(image, block_x, block_y, block);
+
+				uint8_t* out_block = level_data + (block_y * blocks_x + block_x) * 8;
+				if (format == BAKED_FORMAT_BC1)
+					EncodeBC1Block(block, out_block);
+				else
+					EncodeBC4Block(block, out_block);
+			}
+		}
+	}
+
+	static bool WriteBakedTexture(const BakeOptions& options, std::vector<SourceImage>& images)
+	{
+		bool is_single_channel = options.allow_single_channel && IsSingleChannel(images);
+
+		BakedTextureHeader header = {};
+		header.magic = BAKED_TEXTURE_MAGIC;
+		header.version = BAKED_TEXTURE_VERSION;
+		header.type = options.type;
+		header.width = images[0].width;
+		header.height = images[0].height;
+		header.layer_count = static_cast<uint32_t>(images.size());
+
+		if (is_single_channel)
+			header.format = options.use_block_compression ? BAKED_FORMAT_BC4 : BAKED_FORMAT_R8;
+		else
+			header.format = options.use_block_compression ? BAKED_FORMAT_BC1 : BAKED_FORMAT_RGBA8;
+
+		// Full chain down to 1x1
+		header.level_count = 1;
+		while ((std::max(header.width, header.height) >> header.level_count) > 0)
+			header.level_count++;
+
+		std::vector<BakedTextureSubresource> subresources(header.level_count * header.layer_count);
+		std::vector<uint8_t> texel_data;
+		uint32_t data_start = sizeof(BakedTextureHeader) + sizeof(BakedTextureSubresource) * subresources.size();
+
+		//  Header|Subresources|Level 0 Layer 0|Level 0 Layer 1|...|Level 1 Layer 0|...
+		// |----->|----------->|-------------->|-------------->|
+		for (uint32_t level = 0; level < header.level_count; level++)
+		{
+			for (uint32_t layer = 0; layer < header.layer_count; layer++)
+			{
+				BakedTextureSubresource& subresource = subresources[level * header.layer_count + layer];
+				subresource.offset = data_start + static_cast<uint32_t>(texel_data.size());
+				EncodeLevel(images[layer], header.format, texel_data);
+				subresource.size = data_start + static_cast<uint32_t>(texel_data.size()) - subresource.offset;
+			}
+
+			// Each layer steps down to its next level in place
+			if (level + 1 < header.level_count)
+			{
+				for (SourceImage& image : images)
+					image = Downsample(image);
+			}
+		}
+
+		std::ofstream out_file(options.output_path, std::ios::binary | std::ios::trunc);
+		if (!out_file)
+		{
+			std::fprintf(stderr, "Failed to open %s for writing\n", options.output_path);
+			return false;
+		}
+
+		out_file.write(reinterpret_cast<const char*>(&header), sizeof(BakedTextureHeader));
+		out_file.write(reinterpret_cast<const char*>(subresources.data()), sizeof(BakedTextureSubresource) * subresources.size());
+		out_file.write(reinterpret_cast<const char*>(texel_data.data()), texel_data.size());
+
+		if (!out_file)
+		{
+			std::fprintf(stderr, "Failed to write %s\n", options.output_path);
+			return false;
+		}
+
+		const char* format_names[] = { "RGBA8", "R8", "BC1", "BC4" };
+		std::printf("Baked %s (%ux%u x%u, %u levels, %s, %zu bytes)\n", options.output_path, header.width, header.height, header.layer_count, header.level_count, format_names[header.format], texel_data.size());
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BB3D::BakeOptions options = {};
+	if (!BB3D::ParseBakeOptions(argc, argv, options))
+	{
+		std::fprintf(stderr, "Usage: TextureBaker [--bc] [--allow-r8] <2d|array|cube> <output%s> <inputs...>\n", BAKED_TEXTURE_EXTENSION);
+		return 1;
+	}
+
+	std::vector<BB3D::SourceImage> images;
+	if (!BB3D::LoadSourceImages(options, images))
+		return 1;
+
+	if (!BB3D::WriteBakedTexture(options, images))
+		return 1;
+
+	return 0;
+}
\ No newline at end of file